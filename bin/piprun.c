@@ -39,16 +39,41 @@
  *
  * \section synopsis SYNOPSIS
  *
- *	\c \b piprun [-n &lt;N&gt;] &lt;program&gt; ...
+ *	\c \b piprun [-n &lt;N&gt;] [-c &lt;C&gt;|-b|-p &lt;policy&gt;]
+ *	[--report-bindings] &lt;program&gt; ...
  *
  * \section description DESCRIPTION
  * \b Run a program as a PiP task. If \b -n &lt;N&gt; is specified, then
  * \b N PiP tasks are created and run.
  *
+ * \section options OPTIONS
+ *
+ * \b -c &lt;C&gt; binds all PiP tasks to the C-th core, and \b -b binds
+ * them to the cores in a round-robin way. \b -p &lt;policy&gt; binds
+ * them according to the CPU topology found in sysfs, where the policy
+ * is one of the followings:
+ *
+ * - \b compact fills the SMT threads of a core, the cores sharing an
+ *   L3 cache, a NUMA node and a socket, in this order
+ * - \b scatter distributes the PiP tasks over the sockets
+ * - \b l3 places one PiP task on each L3 cache domain
+ * - \b numa distributes the PiP tasks over the NUMA nodes evenly
+ * - \b nosmt is the same as compact but uses only one SMT thread of
+ *   each core
+ *
+ * The physical cores are used before their SMT siblings by the
+ * scatter, l3 and numa policies. If there are more PiP tasks than
+ * the cores, the cores are reused in the same order.
+ * \b --report-bindings prints the binding of each PiP task to stderr.
  *
  * \section environment ENVIRONMENT
  *
  * \subsection PIP_MODE PIP_MODE
+ *
+ * \subsection PIP_BIND PIP_BIND_CORE, PIP_BIND_NUMA_NODE, PIP_BIND_L3_SIBLINGS
+ * When the PiP tasks are bound, the core number, the NUMA node number
+ * and the list of the cores sharing the L3 cache (e.g., "0-7,16-23")
+ * are passed to each PiP task by these environment variables.
  */
 
 #define _GNU_SOURCE
@@ -57,13 +82,276 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <dirent.h>
 #include <pip.h>
 
+#define ENV_BIND_CORE		"PIP_BIND_CORE"
+#define ENV_BIND_NUMA_NODE	"PIP_BIND_NUMA_NODE"
+#define ENV_BIND_L3_SIBLINGS	"PIP_BIND_L3_SIBLINGS"
+
+#define SYSFS_CPU	"/sys/devices/system/cpu"
+#define SYSFS_NODE	"/sys/devices/system/node"
+
+#define CORE_ROUNDROBIN	(-100)
+#define CORE_POLICY	(-200)
+
 static void print_usage( void ) {
-  fprintf( stderr, "%s [-e] [-n N] [-c C] <prog> ...\n", PROGRAM );
+  fprintf( stderr,
+	   "%s [-e] [-n N] [-c C|-b|-p compact|scatter|l3|numa|nosmt] "
+	   "[--report-bindings] <prog> ...\n",
+	   PROGRAM );
   exit( 1 );
 }
 
+/* topology of a CPU (hardware thread) found in sysfs */
+typedef struct {
+  int		cpu;
+  int		package;
+  int		core;		/* core_id in the package */
+  int		smt;		/* 0 for the first thread of a core */
+  int		node;
+  int		l3;		/* the smallest CPU sharing the L3 cache */
+  cpu_set_t	l3set;
+  int		rank;		/* in the domain of the policy */
+} cpuinfo_t;
+
+static int read_line( char *path, char *buf, size_t sz ) {
+  FILE *fp;
+  int err = 0;
+
+  if( ( fp = fopen( path, "r" ) ) == NULL ) return errno;
+  if( fgets( buf, sz, fp ) == NULL ) {
+    err = EIO;
+  } else {
+    buf[strcspn( buf, "\n" )] = '\0';
+  }
+  fclose( fp );
+  return err;
+}
+
+static int read_int( char *path, int dflt ) {
+  char buf[64];
+
+  if( read_line( path, buf, sizeof(buf) ) != 0 ) return dflt;
+  return atoi( buf );
+}
+
+/* parse a cpulist such as "0-3,8,10-11" */
+static int read_cpulist( char *path, cpu_set_t *cpuset ) {
+  char buf[4096], *p, *q;
+  int  from, to;
+  int  err;
+
+  CPU_ZERO( cpuset );
+  if( ( err = read_line( path, buf, sizeof(buf) ) ) != 0 ) return err;
+  for( p=strtok_r( buf, ",", &q ); p!=NULL; p=strtok_r( NULL, ",", &q ) ) {
+    if( sscanf( p, "%d-%d", &from, &to ) != 2 ) to = from = atoi( p );
+    for( ; from<=to && from<CPU_SETSIZE; from++ ) CPU_SET( from, cpuset );
+  }
+  return 0;
+}
+
+static void format_cpulist( cpu_set_t *cpuset, char *buf, size_t sz ) {
+  int i, j, n = 0;
+
+  buf[0] = '\0';
+  for( i=0; i<CPU_SETSIZE; i=j ) {
+    if( !CPU_ISSET( i, cpuset ) ) {
+      j = i + 1;
+      continue;
+    }
+    for( j=i+1; j<CPU_SETSIZE && CPU_ISSET( j, cpuset ); j++ );
+    if( j - 1 == i ) {
+      n += snprintf( buf+n, sz-n, "%s%d", (n>0)?",":"", i );
+    } else {
+      n += snprintf( buf+n, sz-n, "%s%d-%d", (n>0)?",":"", i, j-1 );
+    }
+    if( n >= sz ) break;
+  }
+}
+
+static void get_cpuinfo( int cpu, cpuinfo_t *info ) {
+  char path[256];
+  cpu_set_t set;
+  int i, level;
+
+  info->cpu = cpu;
+  sprintf( path, SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu );
+  info->package = read_int( path, 0 );
+  sprintf( path, SYSFS_CPU "/cpu%d/topology/core_id", cpu );
+  info->core = read_int( path, cpu );
+  info->smt = 0;
+  sprintf( path, SYSFS_CPU "/cpu%d/topology/thread_siblings_list", cpu );
+  if( read_cpulist( path, &set ) == 0 ) {
+    for( i=0; i<cpu; i++ ) if( CPU_ISSET( i, &set ) ) info->smt ++;
+  }
+  /* find the L3 cache, or the package if there is no L3 */
+  CPU_ZERO( &info->l3set );
+  for( i=0; ; i++ ) {
+    sprintf( path, SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, i );
+    if( ( level = read_int( path, -1 ) ) < 0 ) break;
+    if( level != 3 ) continue;
+    sprintf( path, SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, i );
+    (void) read_cpulist( path, &info->l3set );
+    break;
+  }
+  if( CPU_COUNT( &info->l3set ) == 0 ) {
+    sprintf( path, SYSFS_CPU "/cpu%d/topology/core_siblings_list", cpu );
+    if( read_cpulist( path, &info->l3set ) != 0 ) {
+      CPU_SET( cpu, &info->l3set );
+    }
+  }
+  for( i=0; !CPU_ISSET( i, &info->l3set ); i++ );
+  info->l3 = i;
+  info->node = 0;
+}
+
+static void get_numa_nodes( cpuinfo_t *infos, int ncpus ) {
+  struct dirent *de;
+  DIR  *dir;
+  char path[512];
+  cpu_set_t set;
+  int node, i;
+
+  if( ( dir = opendir( SYSFS_NODE ) ) == NULL ) return;
+  while( ( de = readdir( dir ) ) != NULL ) {
+    if( sscanf( de->d_name, "node%d", &node ) != 1 ) continue;
+    snprintf( path, sizeof(path), SYSFS_NODE "/%s/cpulist", de->d_name );
+    if( read_cpulist( path, &set ) != 0 ) continue;
+    for( i=0; i<ncpus; i++ ) {
+      if( CPU_ISSET( infos[i].cpu, &set ) ) infos[i].node = node;
+    }
+  }
+  closedir( dir );
+}
+
+static int cmp_int( int a, int b ) {
+  return ( a > b ) - ( a < b );
+}
+
+/* physical cores first, then the cores close to each other */
+static int cmp_spread( const void *a, const void *b ) {
+  const cpuinfo_t *x = a, *y = b;
+  int c;
+  if( ( c = cmp_int( x->smt,     y->smt     ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->package, y->package ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->node,    y->node    ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->l3,      y->l3      ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->core,    y->core    ) ) != 0 ) return c;
+  return cmp_int( x->cpu, y->cpu );
+}
+
+static int cmp_compact( const void *a, const void *b ) {
+  const cpuinfo_t *x = a, *y = b;
+  int c;
+  if( ( c = cmp_int( x->package, y->package ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->node,    y->node    ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->l3,      y->l3      ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->core,    y->core    ) ) != 0 ) return c;
+  if( ( c = cmp_int( x->smt,     y->smt     ) ) != 0 ) return c;
+  return cmp_int( x->cpu, y->cpu );
+}
+
+static int cmp_rank( const void *a, const void *b ) {
+  const cpuinfo_t *x = a, *y = b;
+  int c;
+  if( ( c = cmp_int( x->rank, y->rank ) ) != 0 ) return c;
+  return cmp_spread( a, b );
+}
+
+static int domain_of( cpuinfo_t *info, char *policy ) {
+  if( strcmp( policy, "scatter" ) == 0 ) return info->package;
+  if( strcmp( policy, "numa"    ) == 0 ) return info->node;
+  return info->l3;
+}
+
+/* round-robin over the domains (sockets, NUMA nodes or L3 caches) */
+static void interleave( cpuinfo_t *infos, int ncpus, char *policy ) {
+  int i, j, d;
+
+  qsort( infos, ncpus, sizeof(cpuinfo_t), cmp_spread );
+  for( i=0; i<ncpus; i++ ) {
+    d = domain_of( &infos[i], policy );
+    for( infos[i].rank=0, j=0; j<i; j++ ) {
+      if( domain_of( &infos[j], policy ) == d ) infos[i].rank ++;
+    }
+  }
+  qsort( infos, ncpus, sizeof(cpuinfo_t), cmp_rank );
+}
+
+/* returns the number of CPUs in the order of the policy, or -1 */
+static int place( char *policy, cpuinfo_t *infos ) {
+  cpu_set_t cpuset;
+  int ncpus = 0, i, j;
+
+  if( sched_getaffinity( getpid(), sizeof(cpuset), &cpuset ) != 0 ) return -1;
+  for( i=0; i<CPU_SETSIZE; i++ ) {
+    if( CPU_ISSET( i, &cpuset ) ) get_cpuinfo( i, &infos[ncpus++] );
+  }
+  get_numa_nodes( infos, ncpus );
+
+  if( strcmp( policy, "compact" ) == 0 ) {
+    qsort( infos, ncpus, sizeof(cpuinfo_t), cmp_compact );
+  } else if( strcmp( policy, "nosmt" ) == 0 ) {
+    for( i=0, j=0; i<ncpus; i++ ) {
+      if( infos[i].smt == 0 ) infos[j++] = infos[i];
+    }
+    ncpus = j;
+    qsort( infos, ncpus, sizeof(cpuinfo_t), cmp_compact );
+  } else if( strcmp( policy, "scatter" ) == 0 ||
+	     strcmp( policy, "numa"    ) == 0 ||
+	     strcmp( policy, "l3"      ) == 0 ) {
+    interleave( infos, ncpus, policy );
+  } else {
+    return -1;
+  }
+  return ncpus;
+}
+
+/* the environment of a task, telling where it is bound */
+static char **bind_env( cpuinfo_t *info ) {
+  extern char **environ;
+  char **envv, cpulist[1024];
+  int n, i;
+
+  for( n=0; environ[n]!=NULL; n++ );
+  if( ( envv = (char**) malloc( sizeof(char*) * ( n + 4 ) ) ) == NULL ) {
+    return NULL;
+  }
+  for( i=0; i<n; i++ ) envv[i] = environ[i];
+  for( i=n; i<n+4; i++ ) envv[i] = NULL;
+  format_cpulist( &info->l3set, cpulist, sizeof(cpulist) );
+  if( asprintf( &envv[n],   "%s=%d", ENV_BIND_CORE,      info->cpu  ) < 0 ||
+      asprintf( &envv[n+1], "%s=%d", ENV_BIND_NUMA_NODE, info->node ) < 0 ||
+      asprintf( &envv[n+2], "%s=%s", ENV_BIND_L3_SIBLINGS, cpulist  ) < 0 ) {
+    for( i=n; i<n+3; i++ ) free( envv[i] );
+    free( envv );
+    return NULL;
+  }
+  return envv;
+}
+
+/* only the last three, added by bind_env(), are allocated */
+static void free_bind_env( char **envv ) {
+  int n, i;
+
+  if( envv == NULL ) return;
+  for( n=0; envv[n]!=NULL; n++ );
+  for( i=n-3; i<n; i++ ) free( envv[i] );
+  free( envv );
+}
+
+static void report_binding( int pipid, cpuinfo_t *info ) {
+  char cpulist[1024];
+
+  format_cpulist( &info->l3set, cpulist, sizeof(cpulist) );
+  fprintf( stderr,
+	   "%s: PIPID[%d] bound to core %d "
+	   "(socket %d, core_id %d, smt %d, NUMA node %d, L3 %s)\n",
+	   PROGRAM, pipid, info->cpu, info->package, info->core,
+	   info->smt, info->node, cpulist );
+}
+
 static int count_cpu( void ) {
   cpu_set_t cpuset;
   int i, c = -1;
@@ -97,6 +385,14 @@ int main( int argc, char **argv ) {
   int opts   = 0;
   int ncores = count_cpu();
   int coreno = PIP_CPUCORE_ASIS;
+  int report = 0;
+  char *policy = NULL;
+  cpuinfo_t *infos = NULL;
+  int ninfos = 0;
+  char ***argvs  = NULL;
+  char ***envvs  = NULL;
+  int    *corenos = NULL;
+  int    *errs    = NULL;
   int i, k;
   int err    = 0;
 
@@ -114,61 +410,98 @@ int main( int argc, char **argv ) {
     } else if( strcmp( argv[i], "-c" ) == 0 && ncores > 0 ) {
       coreno = atoi( argv[++i] ) % ncores;
     } else if( strcmp( argv[i], "-b" ) == 0 ) {
-      coreno = -100;
+      coreno = CORE_ROUNDROBIN;
+    } else if( strcmp( argv[i], "-p" ) == 0 && argv[i+1] != NULL ) {
+      coreno = CORE_POLICY;
+      policy = argv[++i];
+    } else if( strcmp( argv[i], "--report-bindings" ) == 0 ) {
+      report = 1;
     } else {
       print_usage();
     }
   }
   opts |= PIP_OPT_PGRP;
   k = i;
+  if( argv[k] == NULL ) print_usage();
+  if( coreno == CORE_POLICY ) {
+    if( ( infos = (cpuinfo_t*) malloc( sizeof(cpuinfo_t) * CPU_SETSIZE ) )
+	== NULL ) {
+      fprintf( stderr, "not enough memory\n" );
+      return ENOMEM;
+    }
+    if( ( ninfos = place( policy, infos ) ) <= 0 ) {
+      fprintf( stderr, "unknown placement policy '%s'\n", policy );
+      print_usage();
+    }
+  }
   if( ( err = pip_init( &pipid, &ntasks, NULL, opts ) ) != 0 ) {
     fprintf( stderr, "pip_init()=%d\n", err );
   } else {
+    cpuinfo_t info;
     int c;
+
+    argvs   = (char***) malloc( sizeof(char**) * ntasks );
+    envvs   = (char***) calloc( ntasks, sizeof(char**) );
+    corenos = (int*)    malloc( sizeof(int)    * ntasks );
+    errs    = (int*)    malloc( sizeof(int)    * ntasks );
+    if( argvs == NULL || envvs == NULL || corenos == NULL || errs == NULL ) {
+      fprintf( stderr, "not enough memory\n" );
+      err = ENOMEM;
+      goto error;
+    }
     for( i=0; i<ntasks; i++ ) {
-      if( coreno == -100 ) {
-	c = i % ncores;
+      if( coreno == CORE_POLICY ) {
+	info = infos[i % ninfos];
+	c = info.cpu;
       } else {
-	c = coreno;
+	if( coreno == CORE_ROUNDROBIN ) {
+	  c = i % ncores;
+	} else {
+	  c = coreno;
+	}
+	if( ( c = nth_core( c ) ) >= 0 ) {
+	  get_cpuinfo( c, &info );
+	  get_numa_nodes( &info, 1 );
+	}
       }
-      if( ( c = nth_core( c ) ) < 0 ) {
+      if( c < 0 ) {
 	c = PIP_CPUCORE_ASIS;
-      }
-      pipid = i;
-      err = pip_spawn( argv[k],
-		       &argv[k],
-		       NULL,
-		       c,
-		       &pipid,
-		       NULL,
-		       NULL,
-		       NULL );
-      if( err ) {
-	int j;
-
-	if( err == ENOENT ) {
-	  fprintf( stderr, "'%s' not found\n", argv[k] );
-	} else {
-	  fprintf( stderr, "pip_spawn(%s)=%d\n", argv[1], err );
+      } else {
+	if( report ) report_binding( i, &info );
+	if( ( envvs[i] = bind_env( &info ) ) == NULL ) {
+	  fprintf( stderr, "not enough memory\n" );
+	  err = ENOMEM;
+	  goto error;
 	}
-	for( j=0; j<i; j++ ) {
-	  int status, mode, exst;
-	  pip_wait( i, &status );
-	  pip_get_mode( &mode );
-	  if( mode & PIP_MODE_PROCESS ) {
-	    if( WIFEXITED( status ) && ( exst = WEXITSTATUS( status ) ) > 0 ) {
-	      fprintf( stderr, "PIPID[%d] exited with %d\n", i, exst );
-	    } else if( WIFSIGNALED( status ) ) {
-	      int sig = WTERMSIG( status );
-	      fprintf( stderr,
-		       "PIPID[%d] signaled (%s)\n",
-		       i,
-		       strsignal(sig) );
-	    }
+      }
+      argvs[i]   = &argv[k];
+      corenos[i] = c;
+    }
+    err = pip_spawn_n( argv[k], argvs, envvs, corenos, 0, ntasks, NULL, errs );
+    if( err ) {
+      if( err == ENOENT ) {
+	fprintf( stderr, "'%s' not found\n", argv[k] );
+      } else {
+	fprintf( stderr, "pip_spawn(%s)=%d\n", argv[k], err );
+      }
+      for( i=0; i<ntasks; i++ ) {
+	int status, mode, exst;
+	if( errs[i] != 0 ) continue;
+	pip_wait( i, &status );
+	pip_get_mode( &mode );
+	if( mode & PIP_MODE_PROCESS ) {
+	  if( WIFEXITED( status ) && ( exst = WEXITSTATUS( status ) ) > 0 ) {
+	    fprintf( stderr, "PIPID[%d] exited with %d\n", i, exst );
+	  } else if( WIFSIGNALED( status ) ) {
+	    int sig = WTERMSIG( status );
+	    fprintf( stderr,
+		     "PIPID[%d] signaled (%s)\n",
+		     i,
+		     strsignal(sig) );
 	  }
 	}
-	goto error;
       }
+      goto error;
     }
     for( i=0; i<ntasks; i++ ) {
       int status;
@@ -178,5 +511,13 @@ int main( int argc, char **argv ) {
     }
   }
  error:
+  if( envvs != NULL ) {
+    for( i=0; i<ntasks; i++ ) free_bind_env( envvs[i] );
+  }
+  free( envvs );
+  free( argvs );
+  free( corenos );
+  free( errs );
+  free( infos );
   return err;
 }
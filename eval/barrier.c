@@ -0,0 +1,175 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * barrier [-a ALGO] [-B fork|pthread] <N> <ITER>
+ *	N PiP tasks and the root call pip_barrier_wait() ITER times
+ *	and the mean latency of a barrier is reported. ALGO is one of
+ *	central (default), dissemination, tournament and tree, given
+ *	to pip_barrier_init_ex(). With -B, the central barrier is used
+ *	by N processes sharing an mmap()ed region or by N threads as
+ *	the baseline.
+ */
+
+#include <sys/wait.h>
+#include <eval.h>
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			niters;
+} barrier_eval_t;
+
+static barrier_eval_t *barrier_eval;
+
+static const char *barrier_algos[] = {
+  [PIP_BARRIER_CENTRAL]       = "central",
+  [PIP_BARRIER_DISSEMINATION] = "dissemination",
+  [PIP_BARRIER_TOURNAMENT]    = "tournament",
+  [PIP_BARRIER_TREE]          = "tree",
+};
+
+static int barrier_algo( char *name ) {
+  int i;
+
+  for( i=0; i<sizeof(barrier_algos)/sizeof(barrier_algos[0]); i++ ) {
+    if( strcmp( name, barrier_algos[i] ) == 0 ) return i;
+  }
+  fprintf( stderr, "unknown barrier algorithm: %s\n", name );
+  exit( 1 );
+}
+
+static void barrier_loop( barrier_eval_t *eval ) {
+  int i;
+
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) pip_barrier_wait( &eval->barrier );
+  pip_barrier_wait( &eval->barrier );
+}
+
+static void *barrier_thread( void *arg ) {
+  barrier_loop( barrier_eval );
+  return NULL;
+}
+
+static int barrier_task( void ) {
+  barrier_eval_t	*eval;
+  int			pipid;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  barrier_loop( eval );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  pthread_t	*threads = NULL;
+  pid_t		*pids = NULL;
+  double	t0, t1;
+  int		baseline = EVAL_PIP;
+  int		algo = PIP_BARRIER_CENTRAL;
+  int		pipid, ntasks, niters, i;
+
+  if( pip_isa_piptask() ) return barrier_task();
+
+  for( i=1; i<argc-1 && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-B" ) == 0 ) baseline = eval_baseline( argv[++i] );
+    if( strcmp( argv[i], "-a" ) == 0 ) algo = barrier_algo( argv[++i] );
+  }
+  if( i+1 >= argc ||
+      ( ntasks = atoi( argv[i]   ) ) <= 0 ||
+      ( niters = atoi( argv[i+1] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-a ALGO] [-B fork|pthread] <N> <ITER>\n", argv[0] );
+    exit( 1 );
+  }
+  if( baseline == EVAL_FORK ) {
+    barrier_eval = (barrier_eval_t*) eval_shmem( sizeof(barrier_eval_t) );
+  } else {
+    barrier_eval = (barrier_eval_t*) malloc( sizeof(barrier_eval_t) );
+  }
+  barrier_eval->niters = niters;
+  /* the others identify the participants by their PIPIDs */
+  if( baseline != EVAL_PIP ) algo = PIP_BARRIER_CENTRAL;
+  TESTINT( pip_barrier_init_ex( &barrier_eval->barrier, ntasks + 1, algo ) );
+
+  switch( baseline ) {
+  case EVAL_PIP:
+    TESTINT( pip_init( &pipid, &ntasks, (void**) &barrier_eval, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+    break;
+  case EVAL_FORK:
+    pids = (pid_t*) malloc( sizeof(pid_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      if( ( pids[i] = fork() ) == 0 ) {
+	barrier_loop( barrier_eval );
+	_exit( 0 );
+      }
+      if( pids[i] < 0 ) TESTINT( errno );
+    }
+    break;
+  case EVAL_PTHREAD:
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      TESTINT( pthread_create( &threads[i], NULL, barrier_thread, NULL ) );
+    }
+    break;
+  }
+
+  pip_barrier_wait( &barrier_eval->barrier );
+  t0 = gettime();
+  for( i=0; i<niters; i++ ) pip_barrier_wait( &barrier_eval->barrier );
+  t1 = gettime();
+  pip_barrier_wait( &barrier_eval->barrier );
+
+  for( i=0; i<ntasks; i++ ) {
+    switch( baseline ) {
+    case EVAL_PIP:
+      TESTINT( pip_wait( i, NULL ) );
+      break;
+    case EVAL_FORK:
+      if( waitpid( pids[i], NULL, 0 ) < 0 ) TESTINT( errno );
+      break;
+    case EVAL_PTHREAD:
+      TESTINT( pthread_join( threads[i], NULL ) );
+      break;
+    }
+  }
+
+  print_csv_head_mode( "barrier", baseline, barrier_algos[algo], ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) niters );
+  pip_barrier_fin( &barrier_eval->barrier );
+  if( baseline == EVAL_PIP ) TESTINT( pip_fin() );
+  return 0;
+}
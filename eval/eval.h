@@ -0,0 +1,104 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#ifndef _eval_h_
+#define _eval_h_
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pip.h>
+#include <pip_machdep.h>
+
+#define PRINT_FL(FSTR,V)	\
+  fprintf(stderr,"%s:%d %s=%d\n",__FILE__,__LINE__,FSTR,V)
+
+#define TESTINT(F)		\
+  do{int __xyz=(F); if(__xyz){PRINT_FL(#F,__xyz);exit(9);}} while(0)
+
+inline static double gettime( void ) {
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return ((double)tv.tv_sec + (((double)tv.tv_usec) * 1.0e-6));
+}
+
+/* the baselines without PiP, selected by -B fork|pthread */
+#define EVAL_PIP		(0)
+#define EVAL_FORK		(1) /* fork() and a shared mmap() region */
+#define EVAL_PTHREAD		(2) /* plain pthreads, no namespaces */
+
+inline static int eval_baseline( const char *name ) {
+  if( strcmp( name, "fork"    ) == 0 ) return EVAL_FORK;
+  if( strcmp( name, "pthread" ) == 0 ) return EVAL_PTHREAD;
+  fprintf( stderr, "unknown baseline '%s'\n", name );
+  exit( 1 );
+}
+
+/* memory to be shared with the fork()ed children */
+inline static void *eval_shmem( size_t size ) {
+  void *p = mmap( NULL, size, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+  if( p == MAP_FAILED ) {
+    PRINT_FL( "mmap()", errno );
+    exit( 9 );
+  }
+  return p;
+}
+
+/* CSV: benchmark,mode,variant,ntasks,value(s)... */
+inline static void print_csv_head_mode( const char *bench, int baseline,
+					const char *variant, int ntasks ) {
+  const char *mode;
+
+  switch( baseline ) {
+  case EVAL_FORK:    mode = "baseline:fork";    break;
+  case EVAL_PTHREAD: mode = "baseline:pthread"; break;
+  default:	     mode = pip_get_mode_str();
+  }
+  printf( "%s,%s,%s,%d", bench, ( mode != NULL ) ? mode : "-",
+	  variant, ntasks );
+}
+
+inline static void print_csv_head( const char *bench, const char *variant,
+				   int ntasks ) {
+  print_csv_head_mode( bench, EVAL_PIP, variant, ntasks );
+}
+
+#endif
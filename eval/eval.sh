@@ -0,0 +1,47 @@
+#!/bin/sh
+
+# run the benchmarks in every available PiP execution mode
+# and output the results in the CSV format, followed by the
+# fork+shm and pthread baselines
+
+PRELOAD=`pwd`/../preload/pip_preload.so
+NTASKS_LIST=${NTASKS_LIST:-"1 2 4 8 16 32 64 128"}
+NULPS=${NULPS:-1000}
+NITERS=${NITERS:-10000}
+
+echo "benchmark,mode,variant,ntasks,value..."
+
+for mode in pthread process:preload process:pipclone process:clone; do
+    case $mode in
+    process:preload) preload=$PRELOAD;;
+    *)		     preload=;;
+    esac
+    for n in $NTASKS_LIST; do
+	PIP_MODE=$mode LD_PRELOAD=$preload ./spawn    $n 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./spawn -b $n 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./wait     $n 2>/dev/null
+	for algo in central dissemination tournament tree; do
+	    PIP_MODE=$mode LD_PRELOAD=$preload ./barrier -a $algo $n $NITERS \
+		2>/dev/null
+	done
+	PIP_MODE=$mode LD_PRELOAD=$preload ./ulp $n $NULPS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./ulp -s 64 $n $NULPS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./yield    $n $NITERS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./malloc   $n $NITERS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./getaddr  $n $NITERS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./taskline $n $NITERS 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./tlb    $n 2>/dev/null
+	PIP_MODE=$mode LD_PRELOAD=$preload ./tlb -h $n 2>/dev/null
+    done
+done
+
+for n in $NTASKS_LIST; do
+    for base in fork pthread; do
+	./spawn   -B $base $n 2>/dev/null
+	./wait    -B $base $n 2>/dev/null
+	./barrier -B $base $n $NITERS 2>/dev/null
+    done
+    ./yield   -B pthread $n $NITERS 2>/dev/null
+    ./malloc  -B pthread $n $NITERS 2>/dev/null
+    ./getaddr -B pthread $n $NITERS 2>/dev/null
+done
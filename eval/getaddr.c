@@ -0,0 +1,141 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * getaddr [-B pthread] <N> <ITER>
+ *	each of N PiP tasks looks up a variable of its neighbor by
+ *	pip_get_addr() ITER times, and the mean cost of a lookup is
+ *	reported. With -B pthread, N threads call dlsym() instead as
+ *	the baseline.
+ */
+
+#include <dlfcn.h>
+#include <eval.h>
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			ntasks;
+  int			niters;
+} getaddr_eval_t;
+
+static getaddr_eval_t getaddr_eval;
+
+int getaddr_symbol = 0;		/* to be looked up */
+
+static void *getaddr_thread( void *arg ) {
+  getaddr_eval_t *eval = &getaddr_eval;
+  void	*addr;
+  int	i;
+
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    if( ( addr = dlsym( RTLD_DEFAULT, "getaddr_symbol" ) ) == NULL ) {
+      TESTINT( ENOENT );
+    }
+  }
+  pip_barrier_wait( &eval->barrier );
+  return NULL;
+}
+
+static int getaddr_task( void ) {
+  getaddr_eval_t *eval;
+  void		*addr;
+  int		pipid, target, i;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  target = ( pipid + 1 ) % eval->ntasks;
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    TESTINT( pip_get_addr( target, "getaddr_symbol", &addr ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  getaddr_eval_t *eval = &getaddr_eval;
+  pthread_t	*threads = NULL;
+  double	t0, t1;
+  int		baseline = EVAL_PIP;
+  int		pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return getaddr_task();
+
+  for( i=1; i<argc-1 && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-B" ) == 0 ) baseline = eval_baseline( argv[++i] );
+  }
+  if( i+1 >= argc ||
+      ( ntasks       = atoi( argv[i]   ) ) <= 0 ||
+      ( eval->niters = atoi( argv[i+1] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-B pthread] <N> <ITER>\n", argv[0] );
+    exit( 1 );
+  }
+  if( baseline == EVAL_FORK ) {
+    fprintf( stderr, "%s: no fork baseline for symbol lookup\n", argv[0] );
+    exit( 1 );
+  }
+  eval->ntasks = ntasks;
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  if( baseline == EVAL_PIP ) {
+    TESTINT( pip_init( &pipid, &ntasks, (void**) &eval, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+  } else {
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      TESTINT( pthread_create( &threads[i], NULL, getaddr_thread, NULL ) );
+    }
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) {
+    if( baseline == EVAL_PIP ) {
+      TESTINT( pip_wait( i, NULL ) );
+    } else {
+      TESTINT( pthread_join( threads[i], NULL ) );
+    }
+  }
+
+  print_csv_head_mode( "getaddr", baseline,
+		       ( baseline == EVAL_PIP ) ? "pip_get_addr" : "dlsym",
+		       ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) eval->niters );
+  if( baseline == EVAL_PIP ) TESTINT( pip_fin() );
+  return 0;
+}
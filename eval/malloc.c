@@ -0,0 +1,162 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * malloc [-B pthread] <N> <ITER>
+ *	each of N PiP tasks allocates ITER blocks by pip_malloc() and
+ *	then frees the ones allocated by its neighbor by pip_free().
+ *	The mean cost of the allocation and of the (remote) free are
+ *	reported. With -B pthread, N threads do the same with malloc()
+ *	and free() as the baseline. Processes cannot free the memory
+ *	of the others, there is no fork baseline.
+ */
+
+#define PIP_EXPERIMENTAL	/* pip_malloc() and pip_free() */
+#include <eval.h>
+
+#define BLOCK_SIZE	(64)
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			ntasks;
+  int			niters;
+  void			**blocks; /* [ntasks][niters] */
+  int			baseline;
+} malloc_eval_t;
+
+static malloc_eval_t malloc_eval;
+
+static void malloc_loop( malloc_eval_t *eval, int id ) {
+  void	**mine  = &eval->blocks[ id * eval->niters ];
+  void	**other = &eval->blocks[ ( ( id + 1 ) % eval->ntasks ) * eval->niters ];
+  int	i;
+
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    mine[i] = ( eval->baseline == EVAL_PIP ) ?
+      pip_malloc( BLOCK_SIZE ) : malloc( BLOCK_SIZE );
+  }
+  pip_barrier_wait( &eval->barrier );
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    if( eval->baseline == EVAL_PIP ) {
+      pip_free( other[i] );
+    } else {
+      free( other[i] );
+    }
+  }
+  pip_barrier_wait( &eval->barrier );
+}
+
+static void *malloc_thread( void *arg ) {
+  malloc_loop( &malloc_eval, (int)(intptr_t) arg );
+  return NULL;
+}
+
+static int malloc_task( void ) {
+  malloc_eval_t	*eval;
+  int		pipid;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  malloc_loop( eval, pipid );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  malloc_eval_t	*eval = &malloc_eval;
+  pthread_t	*threads = NULL;
+  double	t0, t1, t2, t3;
+  int		pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return malloc_task();
+
+  eval->baseline = EVAL_PIP;
+  for( i=1; i<argc-1 && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-B" ) == 0 ) {
+      eval->baseline = eval_baseline( argv[++i] );
+    }
+  }
+  if( i+1 >= argc ||
+      ( ntasks       = atoi( argv[i]   ) ) <= 0 ||
+      ( eval->niters = atoi( argv[i+1] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-B pthread] <N> <ITER>\n", argv[0] );
+    exit( 1 );
+  }
+  if( eval->baseline == EVAL_FORK ) {
+    fprintf( stderr, "%s: no fork baseline for remote free\n", argv[0] );
+    exit( 1 );
+  }
+  eval->ntasks = ntasks;
+  eval->blocks = (void**) malloc( sizeof(void*) * ntasks * eval->niters );
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  if( eval->baseline == EVAL_PIP ) {
+    TESTINT( pip_init( &pipid, &ntasks, (void**) &eval, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+  } else {
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      TESTINT( pthread_create( &threads[i], NULL, malloc_thread,
+			       (void*)(intptr_t) i ) );
+    }
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  /* the remote free starts after the third barrier, not the second */
+  pip_barrier_wait( &eval->barrier );
+  t2 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t3 = gettime();
+  for( i=0; i<ntasks; i++ ) {
+    if( eval->baseline == EVAL_PIP ) {
+      TESTINT( pip_wait( i, NULL ) );
+    } else {
+      TESTINT( pthread_join( threads[i], NULL ) );
+    }
+  }
+
+  print_csv_head_mode( "malloc", eval->baseline,
+		       ( eval->baseline == EVAL_PIP ) ? "pip_malloc+pip_free" :
+		       "malloc+free", ntasks );
+  printf( ",%g,%g\n",
+	  ( t1 - t0 ) / (double) eval->niters,
+	  ( t3 - t2 ) / (double) eval->niters );
+  if( eval->baseline == EVAL_PIP ) TESTINT( pip_fin() );
+  return 0;
+}
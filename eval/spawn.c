@@ -0,0 +1,133 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * spawn [-b] [-B fork|pthread] <N>
+ *	measures the time to spawn (and wait for) N PiP tasks by
+ *	calling pip_spawn() N times (default, just like piprun used
+ *	to do) or by calling pip_spawn_n() once (-b). With -B, N
+ *	processes (or threads) are created instead as the baseline.
+ *	The latency per task and the throughput (tasks/sec) follow.
+ */
+
+#include <sys/wait.h>
+#include <eval.h>
+
+static void *nop( void *arg ) { return NULL; }
+
+static void spawn_baseline( int baseline, int ntasks ) {
+  pthread_t *threads = NULL;
+  pid_t	*pids = NULL;
+  double t0, t1, t2;
+  int	i;
+
+  if( baseline == EVAL_FORK ) {
+    pids = (pid_t*) malloc( sizeof(pid_t) * ntasks );
+  } else {
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+  }
+  t0 = gettime();
+  for( i=0; i<ntasks; i++ ) {
+    if( baseline == EVAL_FORK ) {
+      if( ( pids[i] = fork() ) == 0 ) _exit( 0 );
+      if( pids[i] < 0 ) TESTINT( errno );
+    } else {
+      TESTINT( pthread_create( &threads[i], NULL, nop, NULL ) );
+    }
+  }
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) {
+    if( baseline == EVAL_FORK ) {
+      if( waitpid( pids[i], NULL, 0 ) < 0 ) TESTINT( errno );
+    } else {
+      TESTINT( pthread_join( threads[i], NULL ) );
+    }
+  }
+  t2 = gettime();
+
+  print_csv_head_mode( "spawn", baseline,
+		       ( baseline == EVAL_FORK ) ? "fork" : "pthread_create",
+		       ntasks );
+  printf( ",%g,%g,%g,%g\n", t1 - t0, t2 - t0,
+	  ( t1 - t0 ) / (double) ntasks, (double) ntasks / ( t1 - t0 ) );
+}
+
+int main( int argc, char **argv ) {
+  char	***argvs;
+  char	*nargv[2];
+  double t0, t1, t2;
+  int	batch = 0, baseline = EVAL_PIP;
+  int	pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return 0; /* PiP task does nothing */
+
+  for( i=1; i<argc && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-b" ) == 0 ) batch = 1;
+    if( strcmp( argv[i], "-B" ) == 0 && i+1 < argc ) {
+      baseline = eval_baseline( argv[++i] );
+    }
+  }
+  if( i >= argc || ( ntasks = atoi( argv[i] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-b] [-B fork|pthread] <N>\n", argv[0] );
+    exit( 1 );
+  }
+  if( baseline != EVAL_PIP ) {
+    spawn_baseline( baseline, ntasks );
+    return 0;
+  }
+  nargv[0] = argv[0];
+  nargv[1] = NULL;
+  argvs = (char***) malloc( sizeof(char**) * ntasks );
+  for( i=0; i<ntasks; i++ ) argvs[i] = nargv;
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  t0 = gettime();
+  if( batch ) {
+    TESTINT( pip_spawn_n( nargv[0], argvs, NULL, NULL, 0, ntasks,
+			  NULL, NULL ) );
+  } else {
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( nargv[0], nargv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+  }
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+  t2 = gettime();
+
+  print_csv_head( "spawn", batch ? "pip_spawn_n" : "pip_spawn", ntasks );
+  printf( ",%g,%g,%g,%g\n", t1 - t0, t2 - t0,
+	  ( t1 - t0 ) / (double) ntasks, (double) ntasks / ( t1 - t0 ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
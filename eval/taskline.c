@@ -0,0 +1,106 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * taskline <N> <ITER>
+ *	each of N PiP tasks calls pip_malloc() and pip_free() (taking
+ *	the lock_malloc of its own task entry) and pip_import() on its
+ *	neighbor (reading the export of the next entry) ITER times.
+ *	If adjacent entries of the task table shared a cache line, the
+ *	time per iteration would grow with N.
+ */
+
+#define PIP_EXPERIMENTAL	/* pip_malloc() and pip_free() */
+#include <eval.h>
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			ntasks;
+  int			niters;
+} taskline_eval_t;
+
+static taskline_eval_t taskline_eval;
+
+static int taskline_task( void ) {
+  taskline_eval_t *eval;
+  void		*exp, *p;
+  int		pipid, next, i;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  TESTINT( pip_export( (void*) eval ) );
+  next = ( pipid + 1 ) % eval->ntasks;
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    p = pip_malloc( 16 );
+    pip_free( p );
+    TESTINT( pip_import( next, &exp ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  taskline_eval_t *eval = &taskline_eval;
+  double	t0, t1;
+  int		ncores = sysconf( _SC_NPROCESSORS_ONLN );
+  int		pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return taskline_task();
+
+  if( argc < 3 ||
+      ( ntasks       = atoi( argv[1] ) ) <= 0 ||
+      ( eval->niters = atoi( argv[2] ) ) <= 0 ) {
+    fprintf( stderr, "%s <N> <ITER>\n", argv[0] );
+    exit( 1 );
+  }
+  eval->ntasks = ntasks;
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  TESTINT( pip_init( &pipid, &ntasks, (void**) &eval, 0 ) );
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    /* one task per core so that the cache lines bounce between cores */
+    TESTINT( pip_spawn( argv[0], argv, NULL, i % ncores, &pipid,
+			NULL, NULL, NULL ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+
+  print_csv_head( "taskline", "malloc+free+import", ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) eval->niters );
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * tlb [-h] <T>
+ *	T PiP tasks walk over a large array in their .bss at random,
+ *	and the dTLB and iTLB misses of each task are counted by
+ *	perf_event_open(2). With -h, PIP_OPT_HUGEPAGE is set so that
+ *	the segments and the stacks are backed by huge pages.
+ */
+
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <eval.h>
+
+#define TLB_ARRAY_SZ	(64*1024*1024)
+#define TLB_NACCESS	(16*1024*1024)
+
+typedef struct {
+  pip_barrier_t		barrier;
+  uint64_t		dtlb[PIP_NTASKS_MAX];
+  uint64_t		itlb[PIP_NTASKS_MAX];
+} tlb_eval_t;
+
+static tlb_eval_t tlb_eval;
+
+static char tlb_array[TLB_ARRAY_SZ];
+
+static int tlb_counter( uint64_t cache ) {
+  struct perf_event_attr attr;
+
+  memset( &attr, 0, sizeof(attr) );
+  attr.size   = sizeof(attr);
+  attr.type   = PERF_TYPE_HW_CACHE;
+  attr.config = cache |
+    ( PERF_COUNT_HW_CACHE_OP_READ     <<  8 ) |
+    ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+  attr.disabled       = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  /* the calling thread (task) only, on any CPU */
+  return syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+static uint64_t tlb_read( int fd ) {
+  uint64_t count;
+
+  if( fd < 0 || read( fd, &count, sizeof(count) ) != sizeof(count) ) {
+    return (uint64_t) -1;
+  }
+  close( fd );
+  return count;
+}
+
+static int tlb_task( void ) {
+  tlb_eval_t	*eval;
+  uint64_t	idx = 0, sum = 0;
+  int		pipid, dtlb, itlb, i;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  dtlb = tlb_counter( PERF_COUNT_HW_CACHE_DTLB );
+  itlb = tlb_counter( PERF_COUNT_HW_CACHE_ITLB );
+  pip_barrier_wait( &eval->barrier );
+  if( dtlb >= 0 ) ioctl( dtlb, PERF_EVENT_IOC_ENABLE, 0 );
+  if( itlb >= 0 ) ioctl( itlb, PERF_EVENT_IOC_ENABLE, 0 );
+  for( i=0; i<TLB_NACCESS; i++ ) {
+    /* LCG, so that the accesses hit random pages */
+    idx = idx * 6364136223846793005ULL + 1442695040888963407ULL;
+    sum += tlb_array[ ( idx >> 16 ) % TLB_ARRAY_SZ ]++;
+  }
+  if( dtlb >= 0 ) ioctl( dtlb, PERF_EVENT_IOC_DISABLE, 0 );
+  if( itlb >= 0 ) ioctl( itlb, PERF_EVENT_IOC_DISABLE, 0 );
+  eval->dtlb[pipid] = tlb_read( dtlb );
+  eval->itlb[pipid] = tlb_read( itlb );
+  pip_barrier_wait( &eval->barrier );
+  TESTINT( pip_fin() );
+  return ( sum == 0 ) ? 1 : 0;	/* not to be optimized out */
+}
+
+int main( int argc, char **argv ) {
+  tlb_eval_t	*eval = &tlb_eval;
+  uint64_t	dtlb = 0, itlb = 0;
+  double	t0, t1;
+  int		opts = 0;
+  int		pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return tlb_task();
+
+  for( i=1; i<argc && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-h" ) == 0 ) opts |= PIP_OPT_HUGEPAGE;
+  }
+  if( i >= argc ||
+      ( ntasks = atoi( argv[i] ) ) <= 0 || ntasks > PIP_NTASKS_MAX ) {
+    fprintf( stderr, "%s [-h] <T>\n", argv[0] );
+    exit( 1 );
+  }
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  TESTINT( pip_init( &pipid, &ntasks, (void**) &eval, opts ) );
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			NULL, NULL, NULL ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+
+  /* -1 if the counter is not available */
+  for( i=0; i<ntasks; i++ ) {
+    if( dtlb != (uint64_t) -1 ) {
+      dtlb = ( eval->dtlb[i] == (uint64_t) -1 ) ? -1 : dtlb + eval->dtlb[i];
+    }
+    if( itlb != (uint64_t) -1 ) {
+      itlb = ( eval->itlb[i] == (uint64_t) -1 ) ? -1 : itlb + eval->itlb[i];
+    }
+  }
+  print_csv_head( "tlb", ( opts & PIP_OPT_HUGEPAGE ) ? "hugepage" : "default",
+		  ntasks );
+  printf( ",%g,%lld,%lld\n", t1 - t0, (long long) dtlb, (long long) itlb );
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * ulp [-s <KiB>] <T> <N>
+ *	T PiP tasks create and finalize N ULPs each in a tight loop,
+ *	measuring the cost of the task slot allocation (and of the
+ *	namespace recycling) under contention. With -s, the ULP stacks
+ *	are KiB each instead of PIP_STACKSZ.
+ */
+
+#include <eval.h>
+#include <pip_ulp.h>
+
+extern int pip_ulp_do_finalize( int, int* );
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			niters;
+  size_t		stack_size;
+} ulp_eval_t;
+
+static ulp_eval_t ulp_eval;
+
+static int ulp_task( char *prog ) {
+  ulp_eval_t	*eval;
+  pip_ulp_t	ulp;
+  pip_spawn_attr_t attr, *attrp = NULL;
+  char		*nargv[2];
+  int		pipid, i;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  nargv[0] = prog;
+  nargv[1] = NULL;
+  if( eval->stack_size > 0 ) {
+    TESTINT( pip_spawn_attr_init( &attr ) );
+    TESTINT( pip_spawn_attr_setstacksize( &attr, eval->stack_size ) );
+    attrp = &attr;
+  }
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    pipid = PIP_PIPID_ANY;
+    TESTINT( pip_ulp_create_ex( prog, nargv, NULL, &pipid, NULL, NULL, &ulp,
+				attrp ) );
+    TESTINT( pip_ulp_do_finalize( pipid, NULL ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  ulp_eval_t	*eval = &ulp_eval;
+  double	t0, t1;
+  int		pipid, ntasks, nulps, i;
+
+  if( pip_isa_piptask() ) return ulp_task( argv[0] );
+
+  for( i=1; i<argc-1 && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-s" ) == 0 ) {
+      eval->stack_size = (size_t) atoi( argv[++i] ) * 1024;
+    }
+  }
+  if( i+1 >= argc ||
+      ( ntasks = atoi( argv[i] ) ) <= 0 ||
+      ( eval->niters = atoi( argv[i+1] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-s <KiB>] <T> <N>\n", argv[0] );
+    exit( 1 );
+  }
+  /* each task holds one ULP at a time */
+  nulps = ntasks * 2;
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  TESTINT( pip_init( &pipid, &nulps, (void**) &eval, PIP_OPT_RECYCLE ) );
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			NULL, NULL, NULL ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+
+  print_csv_head( "ulp",
+		  ( eval->stack_size > 0 ) ? "create+finalize(stack)" :
+		  "create+finalize", ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) ( ntasks * eval->niters ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * wait [-B fork|pthread] <N>
+ *	N PiP tasks are released at once from a barrier and return,
+ *	and the root reaps them by pip_wait(). The time from the
+ *	release to the last pip_wait() is reported with the mean
+ *	reap latency per task. With -B, N processes (waitpid()) or
+ *	threads (pthread_join()) do the same as the baseline.
+ */
+
+#include <sys/wait.h>
+#include <eval.h>
+
+typedef struct {
+  pip_barrier_t		barrier;
+} wait_eval_t;
+
+static wait_eval_t *wait_eval;
+
+static void *wait_thread( void *arg ) {
+  pip_barrier_wait( &wait_eval->barrier );
+  return NULL;
+}
+
+static int wait_task( void ) {
+  wait_eval_t	*eval;
+  int		pipid;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  pip_barrier_wait( &eval->barrier );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  pthread_t	*threads = NULL;
+  pid_t		*pids = NULL;
+  double	t0, t1;
+  int		baseline = EVAL_PIP;
+  int		pipid, ntasks, i;
+
+  if( pip_isa_piptask() ) return wait_task();
+
+  for( i=1; i<argc && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-B" ) == 0 && i+1 < argc ) {
+      baseline = eval_baseline( argv[++i] );
+    }
+  }
+  if( i >= argc || ( ntasks = atoi( argv[i] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-B fork|pthread] <N>\n", argv[0] );
+    exit( 1 );
+  }
+  if( baseline == EVAL_FORK ) {
+    wait_eval = (wait_eval_t*) eval_shmem( sizeof(wait_eval_t) );
+  } else {
+    wait_eval = (wait_eval_t*) malloc( sizeof(wait_eval_t) );
+  }
+  pip_barrier_init( &wait_eval->barrier, ntasks + 1 );
+
+  switch( baseline ) {
+  case EVAL_PIP:
+    TESTINT( pip_init( &pipid, &ntasks, (void**) &wait_eval, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+    break;
+  case EVAL_FORK:
+    pids = (pid_t*) malloc( sizeof(pid_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      if( ( pids[i] = fork() ) == 0 ) {
+	pip_barrier_wait( &wait_eval->barrier );
+	_exit( 0 );
+      }
+      if( pids[i] < 0 ) TESTINT( errno );
+    }
+    break;
+  case EVAL_PTHREAD:
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      TESTINT( pthread_create( &threads[i], NULL, wait_thread, NULL ) );
+    }
+    break;
+  }
+
+  t0 = gettime();
+  pip_barrier_wait( &wait_eval->barrier );
+  for( i=0; i<ntasks; i++ ) {
+    switch( baseline ) {
+    case EVAL_PIP:
+      TESTINT( pip_wait( i, NULL ) );
+      break;
+    case EVAL_FORK:
+      if( waitpid( pids[i], NULL, 0 ) < 0 ) TESTINT( errno );
+      break;
+    case EVAL_PTHREAD:
+      TESTINT( pthread_join( threads[i], NULL ) );
+      break;
+    }
+  }
+  t1 = gettime();
+
+  print_csv_head_mode( "wait", baseline,
+		       ( baseline == EVAL_PIP  ) ? "pip_wait" :
+		       ( baseline == EVAL_FORK ) ? "waitpid"  : "pthread_join",
+		       ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) ntasks );
+  if( baseline == EVAL_PIP ) TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+/*
+ * yield [-B pthread] <N> <ITER>
+ *	each of N PiP tasks creates a ULP and switches to and from it
+ *	by pip_ulp_yield_to() ITER times, and the mean cost of one
+ *	switch is reported. With -B pthread, N threads switch between
+ *	two ucontexts by swapcontext() as the baseline.
+ */
+
+#include <ucontext.h>
+#include <eval.h>
+#include <pip_ulp.h>
+
+extern int pip_ulp_do_finalize( int, int* );
+
+typedef struct {
+  pip_ulp_t		task;
+  pip_ulp_t		ulp;
+  volatile int		done;
+} yield_pair_t;
+
+typedef struct {
+  pip_barrier_t		barrier;
+  int			niters;
+} yield_eval_t;
+
+static yield_eval_t yield_eval;
+
+/* the ULP keeps switching back until the task is done */
+static int yield_ulp( char *arg ) {
+  yield_pair_t	*pair = (yield_pair_t*) strtoul( arg, NULL, 16 );
+  int		pipid;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  while( !pair->done ) TESTINT( pip_ulp_yield_to( &pair->ulp, &pair->task ) );
+  return 0;
+}
+
+/* called on the stack of the terminated ULP */
+static void yield_termcb( void *aux ) {
+  yield_pair_t	*pair = (yield_pair_t*) aux;
+
+  (void) pip_ulp_yield_to( NULL, &pair->task );
+}
+
+static int yield_task( char *prog ) {
+  yield_eval_t	*eval;
+  yield_pair_t	pair;
+  char		ptr[32];
+  char		*nargv[4];
+  int		pipid, i;
+
+  TESTINT( pip_init( &pipid, NULL, (void**) &eval, 0 ) );
+  sprintf( ptr, "%lx", (unsigned long) &pair );
+  nargv[0] = prog;
+  nargv[1] = "-u";
+  nargv[2] = ptr;
+  nargv[3] = NULL;
+  TESTINT( pip_make_ulp( PIP_PIPID_MYSELF, NULL, NULL, &pair.task ) );
+  pipid = PIP_PIPID_ANY;
+  pair.done = 0;
+  TESTINT( pip_ulp_create( prog, nargv, NULL, &pipid, yield_termcb, &pair,
+			   &pair.ulp ) );
+  /* the first switch starts the ULP, not to be measured */
+  TESTINT( pip_ulp_yield_to( &pair.task, &pair.ulp ) );
+
+  pip_barrier_wait( &eval->barrier );
+  for( i=0; i<eval->niters; i++ ) {
+    TESTINT( pip_ulp_yield_to( &pair.task, &pair.ulp ) );
+  }
+  pip_barrier_wait( &eval->barrier );
+  /* let the ULP return, it comes back by yield_termcb() */
+  pair.done = 1;
+  TESTINT( pip_ulp_yield_to( &pair.task, &pair.ulp ) );
+  TESTINT( pip_ulp_do_finalize( pipid, NULL ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
+
+static __thread ucontext_t yield_ctx_main, yield_ctx_other;
+
+static void yield_context( void ) {
+  while( 1 ) swapcontext( &yield_ctx_other, &yield_ctx_main );
+}
+
+static void *yield_thread( void *arg ) {
+  size_t sz = 64 * 1024;
+  int	i;
+
+  getcontext( &yield_ctx_other );
+  yield_ctx_other.uc_stack.ss_sp   = malloc( sz );
+  yield_ctx_other.uc_stack.ss_size = sz;
+  yield_ctx_other.uc_link          = NULL;
+  makecontext( &yield_ctx_other, yield_context, 0 );
+  swapcontext( &yield_ctx_main, &yield_ctx_other );
+
+  pip_barrier_wait( &yield_eval.barrier );
+  for( i=0; i<yield_eval.niters; i++ ) {
+    swapcontext( &yield_ctx_main, &yield_ctx_other );
+  }
+  pip_barrier_wait( &yield_eval.barrier );
+  /* the stack is left, the other context is never resumed */
+  return NULL;
+}
+
+int main( int argc, char **argv ) {
+  yield_eval_t	*eval = &yield_eval;
+  pthread_t	*threads = NULL;
+  double	t0, t1;
+  int		baseline = EVAL_PIP;
+  int		pipid, ntasks, nulps, i;
+
+  if( argc == 3 && strcmp( argv[1], "-u" ) == 0 ) return yield_ulp( argv[2] );
+  if( pip_isa_piptask() ) return yield_task( argv[0] );
+
+  for( i=1; i<argc-1 && *argv[i]=='-'; i++ ) {
+    if( strcmp( argv[i], "-B" ) == 0 ) baseline = eval_baseline( argv[++i] );
+  }
+  if( i+1 >= argc ||
+      ( ntasks       = atoi( argv[i]   ) ) <= 0 ||
+      ( eval->niters = atoi( argv[i+1] ) ) <= 0 ) {
+    fprintf( stderr, "%s [-B pthread] <N> <ITER>\n", argv[0] );
+    exit( 1 );
+  }
+  if( baseline == EVAL_FORK ) {
+    fprintf( stderr, "%s: no fork baseline for ULPs\n", argv[0] );
+    exit( 1 );
+  }
+  pip_barrier_init( &eval->barrier, ntasks + 1 );
+
+  if( baseline == EVAL_PIP ) {
+    /* a task and its ULP */
+    nulps = ntasks * 2;
+    TESTINT( pip_init( &pipid, &nulps, (void**) &eval, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			  NULL, NULL, NULL ) );
+    }
+  } else {
+    threads = (pthread_t*) malloc( sizeof(pthread_t) * ntasks );
+    for( i=0; i<ntasks; i++ ) {
+      TESTINT( pthread_create( &threads[i], NULL, yield_thread, NULL ) );
+    }
+  }
+  pip_barrier_wait( &eval->barrier );
+  t0 = gettime();
+  pip_barrier_wait( &eval->barrier );
+  t1 = gettime();
+  for( i=0; i<ntasks; i++ ) {
+    if( baseline == EVAL_PIP ) {
+      TESTINT( pip_wait( i, NULL ) );
+    } else {
+      TESTINT( pthread_join( threads[i], NULL ) );
+    }
+  }
+
+  /* a round trip is two switches */
+  print_csv_head_mode( "yield", baseline,
+		       ( baseline == EVAL_PIP ) ? "pip_ulp_yield_to" :
+		       "swapcontext", ntasks );
+  printf( ",%g,%g\n", t1 - t0, ( t1 - t0 ) / (double) ( eval->niters * 2 ) );
+  if( baseline == EVAL_PIP ) TESTINT( pip_fin() );
+  return 0;
+}
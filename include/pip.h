@@ -94,6 +94,14 @@
  * wrapper can work with. The latter one can only be specified with
  * the PIP-patched glibc library (see below: \b GLIBC issues).
  *
+ * The third one, \"process:clone\", needs neither of them. The PiP
+ * library calls \b clone() by itself and sets up the TLS block of a
+ * PiP task by using the internal functions of the dynamic loader.
+ * This mode is chosen only when it is specified explicitly, it is
+ * supported on x86_64 only, and the pthread functions relying on the
+ * thread descriptor (e.g., \b pthread_getattr_np() or \b pthread_join()
+ * on the PiP task itself) may not work in a PiP task.
+ *
  * There several function provided by the PiP library to absorb the
  * difference due to the execution mode
  *
@@ -135,9 +143,10 @@
 
 #define PIP_MODE_PTHREAD		(0x1000)
 #define PIP_MODE_PROCESS		(0x2000)
-/* the following two modes are a submode of PIP_MODE_PROCESS */
+/* the following three modes are a submode of PIP_MODE_PROCESS */
 #define PIP_MODE_PROCESS_PRELOAD	(0x2100)
 #define PIP_MODE_PROCESS_PIPCLONE	(0x2200)
+#define PIP_MODE_PROCESS_CLONE		(0x2400)
 #define PIP_MODE_MASK			(0xFF00)
 
 #define PIP_ENV_MODE			"PIP_MODE"
@@ -146,18 +155,32 @@
 #define PIP_ENV_MODE_PROCESS		"process"
 #define PIP_ENV_MODE_PROCESS_PRELOAD	"process:preload"
 #define PIP_ENV_MODE_PROCESS_PIPCLONE	"process:pipclone"
+#define PIP_ENV_MODE_PROCESS_CLONE	"process:clone"
 
 #define PIP_OPT_MASK			(0XFF)
 #define PIP_OPT_FORCEEXIT		(0x01)
 #define PIP_OPT_PGRP			(0x02)
+#define PIP_OPT_RECYCLE			(0x04)
+#define PIP_OPT_ULPSHARE_EXPERIMENTAL	(0x08)
+#define PIP_OPT_SHAREENV		(0x10)
+#define PIP_OPT_NUMABIND		(0x20)
+#define PIP_OPT_HUGEPAGE		(0x40)
 
 #define PIP_ENV_OPTS			"PIP_OPTS"
 #define PIP_ENV_OPTS_FORCEEXIT		"forceexit"
 #define PIP_ENV_OPTS_PGRP		"pgrp"
+#define PIP_ENV_OPTS_RECYCLE		"recycle"
+#define PIP_ENV_OPTS_ULPSHARE_EXPERIMENTAL	"ulpshare_experimental"
+#define PIP_ENV_OPTS_SHAREENV		"shareenv"
+#define PIP_ENV_OPTS_NUMABIND		"numabind"
+#define PIP_ENV_OPTS_HUGEPAGE		"hugepage"
 
 #define PIP_VALID_OPTS	\
   ( PIP_MODE_PTHREAD | PIP_MODE_PROCESS_PRELOAD | PIP_MODE_PROCESS_PIPCLONE | \
-    PIP_OPT_FORCEEXIT | PIP_OPT_PGRP )
+    PIP_MODE_PROCESS_CLONE | \
+    PIP_OPT_FORCEEXIT | PIP_OPT_PGRP | PIP_OPT_RECYCLE | \
+    PIP_OPT_ULPSHARE_EXPERIMENTAL | PIP_OPT_SHAREENV | PIP_OPT_NUMABIND | \
+    PIP_OPT_HUGEPAGE )
 
 #define PIP_ENV_STACKSZ		"PIP_STACKSZ"
 
@@ -166,9 +189,14 @@
 #define PIP_PIPID_MYSELF	(-3)
 
 #define PIP_NTASKS_MAX		(260)
+/* with PIP_OPT_ULPSHARE_EXPERIMENTAL, ULPs do not consume namespaces */
+#define PIP_NTASKS_MAX_ULPSHARE	(4096)
 
 #define PIP_CPUCORE_ASIS 	(-1)
 
+/* including the terminating null character */
+#define PIP_NAMED_EXPORT_NAMELEN	(64)
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -186,14 +214,118 @@
 
 typedef int  (*pip_spawnhook_t)      ( void* );
 
+typedef struct pip_spawn_handle	*pip_spawn_handle_t;
+
+#define PIP_FILE_ACTION_CLOSE		(1)
+#define PIP_FILE_ACTION_DUP2		(2)
+#define PIP_FILE_ACTION_CLOSEFROM	(3)
+
+typedef struct pip_file_action {
+  int			type;	/* PIP_FILE_ACTION_* */
+  int			fd;
+  int			newfd;	/* only for PIP_FILE_ACTION_DUP2 */
+} pip_file_action_t;
+
+/* close the FDs having FD_CLOEXEC (by scanning /proc/self/fd) as if */
+/* the task were exec()ed, only when this is set explicitly          */
+#define PIP_SPAWN_ATTR_CLOEXEC		(0x01)
+
+/* the following bits are set by the pip_spawn_attr_set*() functions */
+#define PIP_SPAWN_ATTR_AFFINITY		(0x0100)
+#define PIP_SPAWN_ATTR_STACKSIZE	(0x0200)
+#define PIP_SPAWN_ATTR_SCHED		(0x0400)
+#define PIP_SPAWN_ATTR_MEMPOLICY	(0x0800)
+
+typedef struct pip_spawn_attr {
+  int			flags;	/* PIP_SPAWN_ATTR_* */
+  int			nactions;
+  pip_file_action_t	*actions;
+  /* CPU affinity, overriding the coreno argument */
+  size_t		cpusetsize;
+  cpu_set_t		*cpuset;
+  /* stack size of the task */
+  size_t		stacksize;
+  /* scheduling policy and priority */
+  int			sched_policy;
+  int			sched_priority;
+  /* NUMA memory policy (see set_mempolicy(2)) */
+  int			mpol_mode;
+  unsigned long		mpol_maxnode;
+  unsigned long		*mpol_nodemask;
+} pip_spawn_attr_t;
+
+/* barrier algorithms (pip_barrier_init_ex()) */
+#define PIP_BARRIER_CENTRAL		(0) /* sense reversing, the default */
+#define PIP_BARRIER_DISSEMINATION	(1)
+#define PIP_BARRIER_TOURNAMENT		(2)
+#define PIP_BARRIER_TREE		(3) /* combining tree along the caches */
+
+struct pip_barrier_ex;
+
 typedef struct pip_barrier {
   int			count_init;
   volatile uint32_t	count;
   volatile int		gsense;
+  int			type;	/* PIP_BARRIER_* */
+  struct pip_barrier_ex	*ex;	/* NULL for PIP_BARRIER_CENTRAL */
 } pip_barrier_t;
 
 #define PIP_BARRIER_INIT(N)	{(N),(N),0}
 
+/* a variable registered by PIP_SHARED() or PIP_SHARED_TLS(), placed */
+/* in the PIP_SHARED_SECTION section of the program                  */
+#define PIP_SHARED_SECTION		"pip_shared_vars"
+
+typedef struct pip_shared_var {
+  const char		*name;
+  void			*addr;	/* NULL for a TLS variable */
+  void			*(*tls_addr)( void ); /* in the calling thread */
+  size_t		size;
+} pip_shared_var_t;
+
+#define PIP_SHARED_ATTR		\
+  __attribute__((used,section(PIP_SHARED_SECTION),aligned(sizeof(void*))))
+
+#define PIP_SHARED(var)						\
+  static pip_shared_var_t pip_shared_var_##var PIP_SHARED_ATTR =	\
+    { #var, (void*) &(var), NULL, sizeof(var) }
+
+#define PIP_SHARED_TLS(var)						\
+  static void *pip_shared_tls_##var( void ) { return (void*) &(var); }	\
+  static pip_shared_var_t pip_shared_var_##var PIP_SHARED_ATTR =	\
+    { #var, NULL, pip_shared_tls_##var, sizeof(var) }
+
+/* spawn phases measured by the PiP library */
+#define PIP_SPAWN_PHASE_SLOT		(0) /* finding a free task slot */
+#define PIP_SPAWN_PHASE_COPY		(1) /* copying argv and envv */
+#define PIP_SPAWN_PHASE_COREBIND	(2) /* binding to the core */
+#define PIP_SPAWN_PHASE_DLMOPEN		(3) /* loading the program */
+#define PIP_SPAWN_PHASE_SYMBOLS		(4) /* pip_find_symbols() */
+#define PIP_SPAWN_PHASE_CLONE		(5) /* clone() or pthread_create() */
+#define PIP_SPAWN_PHASE_GLIBC		(6) /* initializing Glibc */
+#define PIP_SPAWN_PHASE_MAIN		(7) /* from pip_spawn() to main() */
+#define PIP_SPAWN_NPHASES		(8)
+
+#define PIP_SPAWN_STATS_NBINS		(40)
+
+#define PIP_ENV_SPAWN_STATS		"PIP_SPAWN_STATS"
+
+typedef struct pip_phase_stats {
+  uint64_t		count;
+  uint64_t		sum;	/* in ticks */
+  uint64_t		min;
+  uint64_t		max;
+  /* hist[i] counts the ones taking [2^i, 2^(i+1)) ticks */
+  uint64_t		hist[PIP_SPAWN_STATS_NBINS];
+} pip_phase_stats_t;
+
+typedef struct pip_spawn_stats {
+  double		ns_per_tick;
+  pip_phase_stats_t	phase[PIP_SPAWN_NPHASES];
+  uint64_t		image_hits; /* program found in the image cache */
+  uint64_t		image_misses;
+} pip_spawn_stats_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -216,8 +348,11 @@ extern "C" {
    *  process, then this returns PIP_PIPID_ROOT, otherwise it returns
    *  the PIPID of the calling PiP task.
    * \param[in,out] ntasks When called by the PiP root, it specifies
-   *  the maximum number of PiP tasks. When called by a PiP task, then
-   *  it returns the number specified by the PiP root.
+   *  the maximum number of PiP tasks. If this is NULL, the task table
+   *  starts small and grows on demand up to \c PIP_NTASKS_MAX (or
+   *  \c PIP_NTASKS_MAX_ULPSHARE with
+   *  \c PIP_OPT_ULPSHARE_EXPERIMENTAL). When called
+   *  by a PiP task, then it returns the current size of the table.
    * \param[in,out] root_expp If the root PiP is ready to export a
    *  memory region to any PiP task(s), then this parameter points to
    *  the variable holding the exporting address of the root PiP. If
@@ -236,6 +371,63 @@ extern "C" {
    * specified by the \a ntasks argument. There are some limitations
    * come from outside of the PiP library (GLIBC).
    *
+   * If \c PIP_OPT_RECYCLE is set in \a opts, or the \c PIP_OPTS
+   * environment variable (a comma separated list) contains \c recycle,
+   * the namespace of a terminated PiP task is not left behind but
+   * reset to the state just after it was loaded and reused by the
+   * next \c pip_spawn() of the same program. Up to \c PIP_POOL_MAX
+   * (the environment variable, \a ntasks by default) namespaces are
+   * kept, the others are unloaded. Only the writable segments are
+   * reset. The heap and the program break (\c brk) are not, hence the
+   * memory a terminated PiP task did not free is never reclaimed and
+   * the next PiP task allocates from a new heap area.
+   *
+   * \c PIP_OPT_ULPSHARE_EXPERIMENTAL (or \c ulpshare_experimental in
+   * \c PIP_OPTS) is experimental. With this option the ULPs of the
+   * same program created by the same PiP task share one namespace.
+   * Each ULP has its own copy of the writable segments of the
+   * namespace, which are copied out and in by \c pip_ulp_yield_to()
+   * whenever it switches to a ULP whose segments are not in place,
+   * hence a switch costs a \c memcpy() of all of them. The namespace
+   * is unloaded when the last ULP sharing it is finalized. The
+   * segments of libc (and libpthread) are never swapped, so that the
+   * ULPs allocate from one consistent heap (\c malloc() and \c free()
+   * can be called across the yields). All the other global state of
+   * libc is shared by the ULPs as well, which includes:
+   * - \c environ, hence \c getenv() and \c setenv() (the environment
+   *   of the ULP started last is in effect),
+   * - \c __progname and \c program_invocation_name,
+   * - the stdio streams and their buffers,
+   * - the \c atexit() and \c on_exit() lists,
+   * - the locale, the state of \c rand(), \c strtok() and others
+   *   kept in static variables of libc.
+   *
+   * The other allocators keeping their state in their own library
+   * (e.g. tcmalloc, jemalloc) are not supported in this mode. The PiP
+   * library itself is swapped, each ULP has its own PiP state. In
+   * this mode \a ntasks can be up to \c PIP_NTASKS_MAX_ULPSHARE.
+   *
+   * If \c PIP_OPT_SHAREENV is set (or \c shareenv in \c PIP_OPTS),
+   * the strings of the environment variables passed to the PiP tasks
+   * having the same environment are placed in one read-only memory
+   * block shared by them. Only the array of pointers is allocated for
+   * each task. \c setenv() and \c putenv() work as usual, but
+   * modifying the string returned by \c getenv() results in a
+   * segmentation fault.
+   *
+   * If \c PIP_OPT_NUMABIND is set (or \c numabind in \c PIP_OPTS),
+   * the writable segments and the stack of a PiP task bound to CPU
+   * core(s) are moved to the NUMA node of the core(s). See
+   * \c pip_numa_report().
+   *
+   * If \c PIP_OPT_HUGEPAGE is set (or \c hugepage in \c PIP_OPTS),
+   * the loaded segments (text and data) of each namespace, the stacks
+   * of PiP tasks and the stacks of ULPs are advised to be backed by
+   * transparent huge pages (\c MADV_HUGEPAGE), and the segments are
+   * collapsed into huge pages right after loading (\c MADV_COLLAPSE,
+   * Linux 6.1 or later) to reduce the TLB misses. This has no effect
+   * if transparent huge pages are disabled.
+   *
    * \sa pip_export(3), pip_fin(3)
    */
   int pip_init( int *pipidp, int *ntasks, void **root_expp, int opts );
@@ -290,6 +482,11 @@ extern "C" {
    * PiP task cannot be accessible from the \a before and \a after
    * functions.
    *
+   * In the process mode, the spawned PiP task inherits all the file
+   * descriptors of the PiP root, including the ones having the
+   * \c FD_CLOEXEC flag. To close them, as \c exec does, call
+   * \c pip_spawn_ex() with \c PIP_SPAWN_ATTR_CLOEXEC or file actions.
+   *
    * \note In theory, there is no reason to restrict for a PiP task to
    * spawn another PiP task. However, the current implementation fails
    * to do so.
@@ -299,6 +496,383 @@ extern "C" {
 		 pip_spawnhook_t before, pip_spawnhook_t after, void *hookarg);
   /** @}*/
 
+  /**
+   * \brief spawn a number of PiP tasks of the same program at once
+   *  @{
+   * \param[in] filename The executable to run as PiP tasks. If this
+   *  is NULL, then \c argvs[0][0] is used.
+   * \param[in] argvs Array of \a ntasks argument vectors, one for
+   *  each PiP task
+   * \param[in] envvs Array of \a ntasks environment vectors. If this
+   *  is NULL, then all PiP tasks inherit the environment of the PiP
+   *  root.
+   * \param[in] corenos Array of \a ntasks core numbers. If this is
+   *  NULL, then the core binding will not take place.
+   * \param[in] pipid PIPID of the first PiP task. The i-th PiP task
+   *  is spawned with the PIPID of \a pipid + i. If \c PIP_PIPID_ANY
+   *  is specified, then the PIPIDs are up to the PiP library.
+   * \param[in] ntasks Number of PiP tasks to spawn
+   * \param[out] pipids If this is not NULL, the PIPID of the i-th PiP
+   *  task is returned to \a pipids[i].
+   * \param[out] errs If this is not NULL, the error code of spawning
+   *  the i-th PiP task is returned to \a errs[i].
+   *
+   * \return Return 0 when all PiP tasks are spawned successfully.
+   *  Otherwise the first error code is returned.
+   *
+   * The program is examined (ELF check, symbol offsets) once for all
+   * the PiP tasks. While a PiP task is being created, the namespaces
+   * of the following ones are loaded by a helper thread (as
+   * \c pip_pool_prepare() does, within the room of the pool). When
+   * \a envvs is NULL, the strings of the environment of the PiP root
+   * are copied once into a read-only memory block shared by all the
+   * PiP tasks, as with \c PIP_OPT_SHAREENV. A failure of spawning a
+   * PiP task does not prevent the others from being spawned.
+   *
+   * \sa pip_spawn(3)
+   */
+  int pip_spawn_n( char *filename, char ***argvs, char ***envvs,
+		   int *corenos, int pipid, int ntasks,
+		   int *pipids, int *errs );
+  /** @}*/
+
+  /**
+   * \brief spawn a PiP task without waiting for it to be loaded
+   *  @{
+   * \param[in] filename The executable to run as a PiP task
+   * \param[in] argv Argument(s) for the spawned PiP task
+   * \param[in] envv Environment variables for the spawned PiP task
+   * \param[in] coreno Core number for the PiP task to be bound to
+   * \param[in,out] pipidp Specify PIPID of the spawned PiP task. The
+   *  PIPID is assigned and returned before this function returns.
+   * \param[in] before The same with the one of \c pip_spawn()
+   * \param[in] after The same with the one of \c pip_spawn()
+   * \param[in] hookarg The argument for the \a before and \a after
+   *  function call.
+   * \param[out] handlep The spawn handle to be passed to
+   *  \c pip_spawn_test() or \c pip_spawn_wait()
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * This function returns as soon as a PIPID is assigned. Loading
+   * the program and creating the PiP task take place in the
+   * background so that the PiP root can do something else in the
+   * meantime. The spawn handle must be completed by calling
+   * \c pip_spawn_test() or \c pip_spawn_wait() before calling
+   * \c pip_wait() on the PiP task.
+   *
+   * \sa pip_spawn(3), pip_spawn_test(3), pip_spawn_wait(3)
+   */
+  int pip_spawn_async( char *filename, char **argv, char **envv,
+		       int coreno, int *pipidp,
+		       pip_spawnhook_t before, pip_spawnhook_t after,
+		       void *hookarg, pip_spawn_handle_t *handlep );
+  /** @}*/
+
+  /**
+   * \brief test if an asynchronously spawned PiP task reached main()
+   *  @{
+   * \param[in] handle The spawn handle returned by
+   *  \c pip_spawn_async()
+   *
+   * \return Return \c EAGAIN if the PiP task has not yet reached its
+   *  main() function. Otherwise the handle is released and 0 is
+   *  returned on success or an error code is returned when the
+   *  spawn failed.
+   *
+   * \sa pip_spawn_async(3), pip_spawn_wait(3)
+   */
+  int pip_spawn_test( pip_spawn_handle_t handle );
+  /** @}*/
+
+  /**
+   * \brief wait until an asynchronously spawned PiP task reaches main()
+   *  @{
+   * \param[in] handle The spawn handle returned by
+   *  \c pip_spawn_async()
+   *
+   * \return Return 0 on success. Return an error code when the
+   *  spawn failed. In either case the handle is released. If the PiP
+   *  task has already been waited by \c pip_wait(), 0 is returned.
+   *
+   * \sa pip_spawn_async(3), pip_spawn_test(3)
+   */
+  int pip_spawn_wait( pip_spawn_handle_t handle );
+  /** @}*/
+
+  /**
+   * \brief initialize a spawn attribute
+   *  @{
+   * \param[out] attr The spawn attribute to be initialized
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * The initialized attribute has no file action and no flag, and
+   * the other attributes are inherited from the PiP root.
+   * As with \c pip_spawn(), a task spawned by \c pip_spawn_ex() with
+   * this attribute does not close the file descriptors having the
+   * \c FD_CLOEXEC flag, unless \c PIP_SPAWN_ATTR_CLOEXEC is set by
+   * \c pip_spawn_attr_setflags(). This is the only case where
+   * \c /proc/self/fd is scanned.
+   *
+   * \sa pip_spawn_ex(3), pip_spawn_attr_destroy(3)
+   */
+  int pip_spawn_attr_init( pip_spawn_attr_t *attr );
+  /** @}*/
+
+  /**
+   * \brief destroy a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute to be destroyed
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * The attribute can be destroyed right after \c pip_spawn_ex()
+   * returns.
+   */
+  int pip_spawn_attr_destroy( pip_spawn_attr_t *attr );
+  /** @}*/
+
+  /**
+   * \brief set the flags of a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] flags \c PIP_SPAWN_ATTR_* flags
+   *
+   * \return Return 0 on success. Return an error code on error.
+   */
+  int pip_spawn_attr_setflags( pip_spawn_attr_t *attr, int flags );
+  /** @}*/
+
+  /**
+   * \brief add file actions to a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] fd The file descriptor to be closed or duplicated
+   * \param[in] newfd The file descriptor \a fd is duplicated to
+   * \param[in] lowfd All file descriptors greater than or equal to
+   *  this are closed
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * Just like \c posix_spawn_file_actions_addclose(),
+   * \c posix_spawn_file_actions_adddup2() and
+   * \c posix_spawn_file_actions_addclosefrom_np(), the file actions
+   * are taken in the specified order by the spawned task before
+   * calling the before hook. \c close_range() is used for the
+   * close-from action if the kernel supports it. File actions are
+   * ignored if the file descriptor table is shared with the PiP root
+   * (i.e. in the pthread mode).
+   */
+  int pip_spawn_attr_addclose( pip_spawn_attr_t *attr, int fd );
+  int pip_spawn_attr_adddup2( pip_spawn_attr_t *attr, int fd, int newfd );
+  int pip_spawn_attr_addclosefrom( pip_spawn_attr_t *attr, int lowfd );
+  /** @}*/
+
+  /**
+   * \brief set the CPU affinity of a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] cpusetsize The size of \a cpuset in bytes
+   * \param[in] cpuset The CPU set the task is bound to
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * Unlike the \c coreno argument of \c pip_spawn(), a task can be
+   * bound to more than one CPU core (e.g., for OpenMP threads in the
+   * task). The \c coreno argument of \c pip_spawn_ex() is ignored if
+   * this is set. The CPU set is applied while the program is being
+   * loaded, so that the memory is first-touched on the closer NUMA
+   * node, and the task runs with this affinity.
+   *
+   * \sa sched_setaffinity(2), CPU_ALLOC(3)
+   */
+  int pip_spawn_attr_setaffinity( pip_spawn_attr_t *attr,
+				  size_t cpusetsize,
+				  const cpu_set_t *cpuset );
+  /** @}*/
+
+  /**
+   * \brief set the stack size of a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] stacksize The stack size in bytes
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * This overrides the \c PIP_STACKSZ environment variable.
+   */
+  int pip_spawn_attr_setstacksize( pip_spawn_attr_t *attr, size_t stacksize );
+  /** @}*/
+
+  /**
+   * \brief set the scheduling policy of a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] policy The scheduling policy (\c SCHED_OTHER,
+   *  \c SCHED_FIFO, \c SCHED_RR, \c SCHED_BATCH or \c SCHED_IDLE)
+   * \param[in] priority The static priority of the policy
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * \sa sched_setscheduler(2)
+   */
+  int pip_spawn_attr_setschedpolicy( pip_spawn_attr_t *attr,
+				     int policy,
+				     int priority );
+  /** @}*/
+
+  /**
+   * \brief set the NUMA memory policy of a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute
+   * \param[in] mode The memory policy mode (\c MPOL_* defined in
+   *  \c numaif.h)
+   * \param[in] nodemask The bit mask of the NUMA nodes, or NULL
+   * \param[in] maxnode The number of bits in \a nodemask
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * Just like the CPU affinity, the memory policy is applied while
+   * the program is being loaded, and the task runs with this policy.
+   *
+   * \sa set_mempolicy(2)
+   */
+  int pip_spawn_attr_setmempolicy( pip_spawn_attr_t *attr,
+				   int mode,
+				   const unsigned long *nodemask,
+				   unsigned long maxnode );
+  /** @}*/
+
+  /**
+   * \brief spawn a PiP task with a spawn attribute
+   *  @{
+   * \param[in] attr The spawn attribute, or NULL
+   *
+   * The other parameters and the return value are the same as
+   * \c pip_spawn(). With NULL \a attr, this is identical to
+   * \c pip_spawn().
+   *
+   * \sa pip_spawn(3), pip_spawn_attr_init(3)
+   */
+  int pip_spawn_ex( char *filename,
+		    char **argv,
+		    char **envv,
+		    int coreno,
+		    int *pipidp,
+		    pip_spawnhook_t before,
+		    pip_spawnhook_t after,
+		    void *hookarg,
+		    pip_spawn_attr_t *attr );
+  /** @}*/
+
+  /**
+   * \brief load namespaces of a program in advance
+   *  @{
+   * \param[in] filename The executable to be spawned later
+   * \param[in] count Number of namespaces to load
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * This function returns immediately and the specified number of
+   * namespaces of the program are loaded in the background. A
+   * succeeding \c pip_spawn() (or \c pip_ulp_create()) of the same
+   * \a filename takes one of them, if any, instead of loading the
+   * program by itself. The total number of the pre-loaded
+   * namespaces is limited by the \c PIP_POOL_MAX environment
+   * variable (the number of PiP tasks specified at \c pip_init() by
+   * default). This function can only be called by the PiP root.
+   *
+   * \sa pip_pool_stats(3)
+   */
+  int pip_pool_prepare( char *filename, int count );
+  /** @}*/
+
+  /**
+   * \brief get the statistics of the namespace pool
+   *  @{
+   * \param[out] sizep Number of the pre-loaded namespaces ready to use
+   * \param[out] hitsp Number of the spawns taking a pre-loaded namespace
+   * \param[out] missesp Number of the spawns loading a program by
+   *  themselves
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * Any of the parameters can be NULL.
+   *
+   * \sa pip_pool_prepare(3)
+   */
+  int pip_pool_stats( int *sizep, int *hitsp, int *missesp );
+  /** @}*/
+
+  /**
+   * \brief get the statistics of the clone() requests
+   *  @{
+   * \param[out] reqsp Number of the PiP tasks created by the
+   *  preloaded \c clone() wrapper
+   * \param[out] contendedp Number of the requests having waited for
+   *  the other requests to finish
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * In the \c process:preload mode, each thread spawning a PiP task
+   * registers its TID in a small table so that the preloaded
+   * \c clone() wrapper rewrites the flags of that \c clone() call
+   * only. The other \c clone() calls (e.g., by \c pthread_create()
+   * in the root or in OpenMP runtimes) pass through without any lock.
+   * Requests wait only if more than \c PIP_CLONE_NREQS threads are
+   * spawning at the same time. Both values are zero in the other
+   * modes. Any of the parameters can be NULL.
+   */
+  int pip_clone_stats( uint64_t *reqsp, uint64_t *contendedp );
+  /** @}*/
+
+  /**
+   * \brief get the latency histograms of the spawn phases
+   *  @{
+   * \param[out] stats The statistics of each phase, indexed by the
+   *  \c PIP_SPAWN_PHASE_* values
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * Latencies are measured in ticks of the cycle counter (TSC on
+   * x86_64, the virtual counter on AArch64) and \c ns_per_tick gives
+   * the conversion factor calibrated since \c pip_init(). If the
+   * \c PIP_SPAWN_STATS environment variable is set, the histograms
+   * are printed to stderr at \c pip_fin(). This function can only be
+   * called by the PiP root.
+   *
+   * \c image_hits and \c image_misses count the lookups of the
+   * information of the programs (PIE check, symbol offsets) cached by
+   * the device, inode and modification time of the program file. Each
+   * lookup calls \c stat() so that a program rebuilt in place is
+   * checked again.
+   */
+  int pip_get_spawn_stats( pip_spawn_stats_t *stats );
+  /** @}*/
+
+  /**
+   * \brief report the NUMA nodes where the pages of the calling task are
+   *  @{
+   * \param[in] fp The output stream
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * For each writable segment of the DSOs loaded in the namespace of
+   * the calling PiP task, and its stack, the number of pages on each
+   * NUMA node (\c N<node>=<pages>, as in \c /proc/self/numa_maps) and
+   * the number of pages not allocated yet are printed. If
+   * \c PIP_OPT_NUMABIND is set (or \c numabind in \c PIP_OPTS), these
+   * pages are moved by \c mbind() to the NUMA node of the CPU core(s)
+   * the task is bound to, right after the program is loaded, and the
+   * memory allocated by the task afterwards (e.g., malloc arenas)
+   * prefers the node. This function can only be called by a PiP task.
+   *
+   * \sa move_pages(2), pip_spawn_attr_setaffinity(3)
+   */
+  int pip_numa_report( FILE *fp );
+  /** @}*/
+
   /**
    * \brief export a memory region of the calling PiP root or a PiP task to
    * the others.
@@ -341,6 +915,55 @@ extern "C" {
   int pip_import( int pipid, void **expp );
   /** @}*/
 
+  /**
+   * \brief export a named memory region of the calling PiP root or a
+   * PiP task to the others.
+   *  @{
+   * \param[in] name Name of the region, must be shorter than
+   *  \c PIP_NAMED_EXPORT_NAMELEN characters.
+   * \param[in] addr Starting address of the region.
+   * \param[in] size Size of the region in bytes, just passed to the
+   *  importers.
+   *
+   * \return Return 0 on success. Return an error code on error.
+   * \retval EINVAL \a name is NULL or too long
+   * \retval EBUSY The caller has already exported the same name
+   * \retval ENOSPC The registry is full
+   *
+   * Unlike \c pip_export(), this can be called any number of times
+   * with different names. The registry is a lock-free hash table in
+   * the region owned by the PiP root, and the exported regions of a
+   * PiP task are removed from it when the task is waited.
+   *
+   * \sa pip_named_import(3), pip_export(3)
+   */
+  int pip_named_export( const char *name, void *addr, size_t size );
+  /** @}*/
+
+  /**
+   * \brief import a named memory region exported by the other.
+   *  @{
+   * \param[in] pipid The PIPID of the exporter, or PIP_PIPID_ROOT
+   * \param[in] name Name given to \c pip_named_export()
+   * \param[out] addrp Starting address of the region
+   * \param[out] sizep Size of the region, if not NULL
+   * \param[in] timeout Relative time to wait for the region to be
+   *  exported. If this is NULL, wait forever.
+   *
+   * \return Return 0 on success. Return an error code on error.
+   * \retval ETIMEDOUT The region is not exported within \a timeout
+   *
+   * The caller blocks in the kernel (futex), not spinning, until the
+   * region is exported. Hence there is no need of barriers between the
+   * exporter and the importers. The exporter may not be spawned yet,
+   * even if its PIPID is beyond the current size of the task table.
+   *
+   * \sa pip_named_export(3)
+   */
+  int pip_named_import( int pipid, const char *name, void **addrp,
+			size_t *sizep, const struct timespec *timeout );
+  /** @}*/
+
   /**
    * \brief import the exposed memory region of the other.
    *  @{
@@ -361,10 +984,101 @@ extern "C" {
    *
    * \note By definition of the dlsym() Glibc function, this may
    * return NULL even if the variable having the specified name exists.
+   *
+   * \note The addresses found are cached per PiP task, the second and
+   * later lookups of the same name take no lock. The cache is cleared
+   * when the PiP task is finalized.
+   *
+   * \sa pip_get_addr_all(3)
    */
   int pip_get_addr( int pipid, const char *symnam, void **addrp );
   /** @}*/
 
+  /**
+   * \brief get the addresses of a variable of all PiP tasks.
+   *  @{
+   * \param[in] symnam The name of a symbol
+   * \param[out] addrs Array of \a ntasks addresses, \c addrs[i] is set
+   *  to the address in the PiP task of PIPID \c i, or NULL if there is
+   *  no such task or no such symbol.
+   * \param[in] ntasks Number of the elements of \a addrs
+   *
+   * \return Return 0 on success. Return an error code on error.
+   *
+   * This is the same with calling \c pip_get_addr() \a ntasks times,
+   * but the lock for \c dlsym() is taken only once.
+   *
+   * \sa pip_get_addr(3)
+   */
+  int pip_get_addr_all( const char *symnam, void **addrs, int ntasks );
+  /** @}*/
+
+  /**
+   * \brief get the address of a variable registered by \c PIP_SHARED()
+   *  @{
+   * \param[in] pipid The PIPID of the owner, or PIP_PIPID_ROOT
+   * \param[in] name Name of the variable
+   * \param[out] addrp The address of the variable of the PiP task
+   *  specified by \a pipid
+   * \param[out] sizep Size of the variable, if not NULL
+   *
+   * \return Return 0 on success. Return an error code on error.
+   * \retval ESRCH The PiP task is not loaded
+   * \retval ENOENT No such variable is registered
+   * \retval EAGAIN The variable is a TLS one and the PiP task has not
+   *  yet resolved it
+   *
+   * A variable is registered by writing \c PIP_SHARED(var) or, for a
+   * TLS variable, \c PIP_SHARED_TLS(var) at file scope of the
+   * program, after the definition of the variable. This works for
+   * static variables too, for which \c pip_get_addr() does not. The
+   * registered variables are put in an ELF section of the program and
+   * the table of them is made when the program is loaded, so that the
+   * lookup needs neither \c dlsym() nor any lock.
+   *
+   * The address of a TLS variable is the one of the thread calling
+   * the \c main() function of the PiP task, and it is resolved just
+   * before the \c main() function is called. For a ULP, it is the
+   * one of the PiP task running the ULP when the ULP starts.
+   *
+   * \note Only the variables of the program itself are registered,
+   * not the ones of the shared libraries it is linked with.
+   *
+   * \sa pip_get_addr(3)
+   */
+  int pip_get_shared( int pipid, const char *name, void **addrp,
+		      size_t *sizep );
+  /** @}*/
+
+  /**
+   * \brief get the address of the same variable of the other PiP task
+   *  @{
+   * \param[in] pipid The PIPID of the other PiP task
+   * \param[in] addr Address of a variable of the calling PiP task
+   * \param[out] remotep The address of the same variable of the PiP
+   *  task specified by \a pipid
+   *
+   * \return Return 0 on success. Return an error code on error.
+   * \retval EPERM The caller is not a PiP task
+   * \retval ESRCH The PiP task is not loaded
+   * \retval EFAULT \a addr is not in the data or bss segments of the
+   *  caller
+   * \retval ESTALE The PiP task is a different program or is linked
+   *  with different shared libraries
+   *
+   * The writable segments of each PiP task are recorded when the
+   * program is loaded. Since a segment is loaded as a whole, the
+   * address is computed by adding the distance between the segment
+   * of the caller and the one of the other, without \c dlsym() or
+   * any lock. Any global or static variable, including the ones in
+   * the shared libraries, can be given, but not TLS variables nor
+   * the ones in the heap or stack.
+   *
+   * \sa pip_get_addr(3), pip_get_shared(3)
+   */
+  int pip_remote_addr( int pipid, const void *addr, void **remotep );
+  /** @}*/
+
   /**
    * \brief get PIPID
    *  @{
@@ -523,10 +1237,59 @@ extern "C" {
    *
    * \note This barrier synchronization never blocks.
    *
+   * \sa pip_barrier_init_ex(3)
    */
   void pip_barrier_wait( pip_barrier_t *barrp );
   /** @}*/
 
+  /**
+   * \brief initialize barrier synchronization structure with an algorithm
+   *  @{
+   *
+   * \param[in] barrp pointer to a PiP barrier structure
+   * \param[in] n number of participants of this barrier synchronization
+   * \param[in] type \c PIP_BARRIER_CENTRAL, \c PIP_BARRIER_DISSEMINATION,
+   *  \c PIP_BARRIER_TOURNAMENT or \c PIP_BARRIER_TREE
+   *
+   * \return Return 0 on success. Return an error code on error.
+   * \retval EINVAL \a n or \a type is invalid
+   * \retval ENOMEM Not enough memory
+   *
+   * With \c PIP_BARRIER_CENTRAL, this is the same with
+   * \c pip_barrier_init(). With the others, every participant spins on
+   * its own flag in its own cache line, instead of the single counter
+   * all the participants update. \c PIP_BARRIER_TREE is a combining
+   * tree whose fan-in is the number of the CPU cores (not counting
+   * the SMT threads) sharing a L3 cache, then the number of the L3
+   * caches in a socket.
+   *
+   * \note With the algorithms other than \c PIP_BARRIER_CENTRAL, the
+   * participants are identified by their PIPIDs and they must be the
+   * PiP tasks of PIPID 0 to \a n-1, or 0 to \a n-2 and the PiP root
+   * (taking the rank of \a n-1). If both the PiP root and the PiP
+   * task of PIPID \a n-1 wait, the later one reports an error and
+   * returns without synchronizing. \c PIP_BARRIER_TREE groups the
+   * participants by their PIPIDs, not by the CPU cores they are
+   * running on. It matches the topology only if consecutive PIPIDs
+   * are bound to neighboring cores, e.g., by
+   * \c piprun \c -p \c compact.
+   * \c pip_barrier_fin() must be called to free the barrier.
+   *
+   * \sa pip_barrier_wait(3), pip_barrier_fin(3)
+   */
+  int pip_barrier_init_ex( pip_barrier_t *barrp, int n, int type );
+  /** @}*/
+
+  /**
+   * \brief free the barrier initialized by \c pip_barrier_init_ex()
+   *  @{
+   *
+   * \param[in] barrp pointer to a PiP barrier structure
+   *
+   */
+  void pip_barrier_fin( pip_barrier_t *barrp );
+  /** @}*/
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
   int  pip_idstr( char *buf, size_t sz );
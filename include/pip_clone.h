@@ -44,14 +44,26 @@
 
 #include <pip_machdep.h>
 
-#define PIP_LOCK_UNLOCKED	(0)
-#define PIP_LOCK_OTHERWISE	(0xFFFFFFFF)
+#include <sys/types.h>
+#include <stdint.h>
+
+/* max. number of PiP clone()s in progress at the same time */
+#define PIP_CLONE_NREQS		(64)
+
+/* a clone() request of PiP, keyed by the TID of the requesting thread */
+typedef struct pip_clone_req {
+  volatile pid_t tid;	     /* requester, or zero if the slot is free */
+  int		pid_clone;   /* pid of the created child task */
+} pip_clone_req_t;
 
 typedef struct pip_clone {
-  pip_spinlock_t lock;	     /* lock */
+  volatile int	nreqs;	     /* number of the requests in progress */
   int		flag_clone;  /* clone flags set by the wrapper func */
-  int		pid_clone;   /* pid os the created child task */
   void		*stack;	     /* this is just for checking stack pointer */
+  /* for diagnosis */
+  volatile uint64_t count_reqs;      /* number of the requests */
+  volatile uint64_t count_contended; /* requests waited for a free slot */
+  pip_clone_req_t reqs[PIP_CLONE_NREQS];
 } pip_clone_t;
 
 #endif
@@ -44,6 +44,7 @@
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #include <pip_machdep.h>
@@ -103,31 +104,205 @@ typedef struct {
   char			***environ;    /* pointer to the environ variable */
 } pip_symbols_t;
 
+#define PIP_SYMBOLS_MAX	(sizeof(pip_symbols_t)/sizeof(void*))
+
+/* where a symbol was found, relative to the DSO in the namespace */
+typedef struct {
+  int			index;	/* position in the link map list, or -1 */
+  char			*dso;	/* l_name of the DSO to double-check */
+  ptrdiff_t		offset;	/* from l_addr of the DSO */
+} pip_symoff_t;
+
+/* cached information of a program, keyed by (dev,ino,mtime) */
+typedef struct pip_image {
+  struct pip_image	*next;
+  dev_t			dev;
+  ino_t			ino;
+  struct timespec	mtime;
+  int			err_pie; /* result of pip_check_pie() */
+  char			*realpath;
+  volatile int		flag_symoffs; /* symoffs[] are valid */
+  pip_symoff_t		symoffs[PIP_SYMBOLS_MAX];
+  /* the PIP_SHARED_SECTION section, relative to the load address */
+  uintptr_t		shared_off;
+  size_t		shared_size; /* zero if there is none */
+} pip_image_t;
+
 typedef struct {
   int			pipid;
   int			coreno;
   char			*prog;
   char			**argv;
   char			**envv;
+  struct pip_env_block	*envblk; /* PIP_OPT_SHAREENV or pip_spawn_n() */
+  pip_image_t		*image;	 /* resolved once by pip_spawn_n() */
 } pip_spawn_args_t;
 
+/* a writable segment and its pristine image (PIP_OPT_RECYCLE) */
+typedef struct {
+  void			*addr;
+  size_t		size;
+  void			*image;
+  int			shared;	/* libc, not swapped by ULPs */
+} pip_segment_t;
+
+/* a loaded (and relocated) namespace not yet assigned to any task */
+typedef struct pip_namespace {
+  struct pip_namespace	*next;
+  char			*prog;
+  void			*loaded;
+  pip_symbols_t		symbols;
+  pip_segment_t		*segs;	/* NULL unless PIP_OPT_RECYCLE */
+  int			nsegs;
+  size_t		segs_size;	/* sum of the non-shared segments */
+  /* for the ULPs sharing it (PIP_OPT_ULPSHARE_EXPERIMENTAL) */
+  int			parent_pipid;	/* the task creating the ULPs, */
+  uint64_t		parent_tick;	/* and its tick_spawn */
+  void			*owner;		/* whose segments are in place */
+  int			nrefs;		/* under lock_pool */
+} pip_namespace_t;
+
+/* read-only environment strings shared by tasks (PIP_OPT_SHAREENV) */
+typedef struct pip_env_block {
+  struct pip_env_block	*next;
+  uint64_t		hash;
+  int			count;	/* number of the variables */
+  int			nrefs;	/* number of the tasks using it */
+  size_t		size;	/* of the mmap()ed vec */
+  char			**vec;	/* followed by the strings */
+} pip_env_block_t;
+
+/* an entry of the named export registry (pip_named_export()), an */
+/* open addressing hash table updated lock-free                    */
+#define PIP_NAMED_EXPORT_MAX	(1024) /* must be a power of two */
+
+#define PIP_NAMED_EMPTY		(0)
+#define PIP_NAMED_BUSY		(1) /* being written */
+#define PIP_NAMED_READY		(2)
+#define PIP_NAMED_DEAD		(3) /* its exporter has terminated */
+
+typedef struct {
+  volatile uint32_t	state;
+  int			pipid;	/* of the exporter */
+  uint64_t		hash;	/* of the name */
+  void			*addr;
+  size_t		size;
+  char			name[PIP_NAMED_EXPORT_NAMELEN];
+} pip_named_export_t;
+
+/* per-task cache of the symbol addresses (pip_get_addr()), */
+/* an open addressing hash table filled lock-free            */
+#define PIP_SYMCACHE_SZ		(16) /* must be a power of two */
+#define PIP_SYMCACHE_NAMELEN	(40) /* longer names are not cached */
+
+typedef struct {
+  volatile uint32_t	state;	/* PIP_NAMED_* */
+  uint64_t		hash;
+  void			*addr;
+  char			name[PIP_SYMCACHE_NAMELEN];
+} pip_symcache_t;
+
+/* per-task table of the variables registered by PIP_SHARED(), */
+/* made when the program is loaded and never changed but the    */
+/* addresses of the TLS variables resolved by the task itself   */
+typedef struct {
+  uint64_t		hash;	/* of the name */
+  pip_shared_var_t	*var;	/* in the PIP_SHARED_SECTION section */
+  void * volatile	addr;	/* NULL until a TLS variable is resolved */
+} pip_shared_ent_t;
+
+typedef struct {
+  int			mask;	/* number of the slots minus one */
+  int			ntls;	/* number of the TLS variables */
+  pip_shared_ent_t	ents[];	/* open addressing hash table */
+} pip_shared_table_t;
+
+/* per-task layout of the writable segments of the loaded namespace, */
+/* in the order found by dl_iterate_phdr() (pip_remote_addr())         */
+typedef struct {
+  uintptr_t		start;
+  size_t		size;
+  uint64_t		hash;	/* of the DSO name */
+} pip_region_t;
+
+typedef struct {
+  int			nregs;
+  pip_region_t		regs[];
+} pip_layout_t;
+
+/* the flags of the barriers other than PIP_BARRIER_CENTRAL, each  */
+/* participant has PIP_BARRIER_SLOTS() flags each in a cache line,  */
+/* holding the number of the barriers it has passed (plus one)      */
+#define PIP_BARRIER_LEVELS_MAX	(32)
+#define PIP_BARRIER_TREE_FANIN	(4) /* above the socket level */
+
+typedef union {
+  volatile uint32_t	val;
+  char			__filler__[PIP_CACHE_SZ];
+} pip_barrier_flag_t;
+
+typedef struct pip_barrier_ex {
+  int			n;
+  int			nrounds; /* dissemination and tournament */
+  int			nlevels; /* combining tree */
+  int			fanin[PIP_BARRIER_LEVELS_MAX];
+  int			span[PIP_BARRIER_LEVELS_MAX]; /* fanin[0]*..*fanin[k] */
+  int			nslots;	/* per participant */
+  pip_barrier_flag_t	flags[] __attribute__((aligned(PIP_CACHE_SZ)));
+} pip_barrier_ex_t;
+
+/* slot k<nrounds (or nlevels) for arrival, then owner, release and */
+/* episode                                                           */
+#define PIP_BARRIER_FLAG(ex,r,k)	(&(ex)->flags[(r)*(ex)->nslots+(k)].val)
+#define PIP_BARRIER_OWNER(ex)		((ex)->nslots-3)
+#define PIP_BARRIER_RELEASE(ex)		((ex)->nslots-2)
+#define PIP_BARRIER_EPISODE(ex)		((ex)->nslots-1)
+
 #define PIP_TYPE_NONE	(0)
 #define PIP_TYPE_ROOT	(1)
 #define PIP_TYPE_TASK	(2)
 #define PIP_TYPE_ULP	(3)
 
+#define PIP_MAIN_NOTYET	(0)
+#define PIP_MAIN_ENTERED	(1)
+#define PIP_MAIN_FAILED	(2)
+#define PIP_MAIN_RETURNED	(3) /* ULP only */
+
 struct pip_gdbif_task;
 
+/* Each entry of the task table starts at a cache line. The fields   */
+/* read by the other tasks or written while the task is running come */
+/* first, then the lock for pip_malloc(), each in its own cache line, */
+/* and the large and rarely touched fields follow.                    */
 typedef struct pip_task {
-  int			pipid;	 /* PiP ID */
-  int			type;	 /* PIP_TYPE_TASK or PIP_TYPE_ULP */
+  union {
+    struct {			/* hot */
+      int		pipid;	 /* PiP ID */
+      int		type;	 /* PIP_TYPE_TASK or PIP_TYPE_ULP */
+      void		*export;
+      int		retval;
+      volatile uint32_t	flag_main; /* futex word, PIP_MAIN_* */
+    };
+    char		__hot_filler__[PIP_CACHE_SZ];
+  };
+  union {
+    pip_spinlock_t	lock_malloc; /* lock for pip_malloc and pip_free */
+    char		__lock_filler__[PIP_CACHE_SZ];
+  };
 
-  void			*export;
+  /* cold */
   ucontext_t		*ctx_exit;
   void			*loaded;
+  pip_namespace_t	*ns;	 /* to be recycled, if any */
+  pip_namespace_t	*ns_shared; /* ULP sharing the namespace */
+  void			*ns_image;  /* and its private segments */
   pip_symbols_t		symbols;
+  pip_shared_table_t	*shared; /* PIP_SHARED() variables, if any */
+  pip_layout_t		*layout; /* for pip_remote_addr() */
   pip_spawn_args_t	args;	/* arguments for a PiP task */
-  int			retval;
+  uint64_t		tick_spawn; /* when pip_spawn() is called */
+  pip_spawn_attr_t	attr;	/* copied from pip_spawn_ex() */
+  int			numa_node; /* where it is placed (PIP_OPT_NUMABIND) */
 
   struct pip_gdbif_task	*gdbif_task;
 
@@ -139,18 +314,44 @@ typedef struct pip_task {
       pip_spawnhook_t	hook_before;
       pip_spawnhook_t	hook_after;
       void		*hook_arg;
-      pip_spinlock_t	lock_malloc; /* lock for pip_malloc and pip_free */
+      /* process:clone mode, released when the task is waited */
+      void		*clone_tls;	  /* made by _dl_allocate_tls() */
+      void		*clone_stack;
+      size_t		clone_stack_size;
     };
     struct {			/* for PiP ULPs */
       struct pip_task	*task_parent;
       void		*stack;
+      size_t		stack_size;
       struct pip_ulp	*ulp;
     };
   };
-} pip_task_t;
+  /* cleared when the task is finalized, not by pip_init_task_struct() */
+  pip_symcache_t	symcache[PIP_SYMCACHE_SZ];
+} __attribute__((aligned(PIP_CACHE_SZ))) pip_task_t;
+
+struct pip_spawn_handle {
+  pthread_t		thread;	/* helper thread loading the task */
+  pip_task_t		*task;
+  int			pipid;	/* to check the task is still the one */
+  uint64_t		tick;	/* tick_spawn of the task */
+  size_t		stack_size;
+  int			err;
+  int			joined;
+};
+
+#define PIP_ENV_POOL_MAX	"PIP_POOL_MAX"
 
 #define PIP_FILLER_SZ	(PIP_CACHE_SZ-sizeof(pip_spinlock_t))
 
+#define PIP_TASK_SLOT_WORDS	((PIP_NTASKS_MAX_ULPSHARE+63)/64)
+
+/* the task table grows by this number of tasks (when pip_init() is */
+/* called without ntasks), the entries never move once allocated    */
+#define PIP_TASK_SEG_SZ		(64)
+#define PIP_TASK_SEGS_MAX	\
+  ((PIP_NTASKS_MAX_ULPSHARE+PIP_TASK_SEG_SZ-1)/PIP_TASK_SEG_SZ)
+
 typedef struct {
   char			magic[PIP_MAGIC_LEN];
   unsigned int		version;
@@ -162,10 +363,12 @@ typedef struct {
       size_t		page_size;
       unsigned int	opts;
       unsigned int	actual_mode;
-      int		ntasks;
+      volatile int	ntasks;	/* current size of the task table */
+      int		ntasks_init; /* in tasks[] */
+      int		ntasks_max;  /* up to which the table may grow */
       int		ntasks_curr;
       int		ntasks_accum;
-      int		pipid_curr;
+      int		pipid_curr; /* where to start searching a free slot */
       pip_clone_t	*cloneinfo;   /* only valid with process:preload */
     };
     char		__filler0__[PIP_FILLER_SZ];
@@ -175,11 +378,44 @@ typedef struct {
     struct {
       void		*stack_flist;	  /* ULP: stack free list */
       size_t		stack_size;
-      pip_task_t	*task_root; /* points to tasks[ntasks] */
+      pip_task_t	*task_root; /* points to tasks[ntasks_init] */
     };
     char		__filler1__[PIP_FILLER_SZ];
   };
-  pip_spinlock_t	lock_tasks; /* lock for finding a new task id */
+  pip_spinlock_t	lock_pool; /* lock for the namespace pool */
+  union {
+    struct {
+      pip_namespace_t	*pool;	/* pre-loaded namespaces */
+      pip_namespace_t	*shared; /* namespaces shared by ULPs */
+      int		pool_size;
+      int		pool_max;
+      volatile int	pool_loading; /* number of namespaces being loaded */
+      volatile int	pool_stop; /* pip_fin() stops the loaders */
+      int		pool_hits;
+      int		pool_misses;
+    };
+    char		__filler2__[PIP_FILLER_SZ];
+  };
+  pip_spinlock_t	lock_images; /* lock for the image and env. caches */
+  union {
+    struct {
+      pip_image_t	*images;
+      pip_env_block_t	*env_blocks;
+    };
+    char		__filler3__[PIP_FILLER_SZ];
+  };
+  pip_spinlock_t	lock_tasks; /* lock for growing the task table */
+  /* the tasks (and their gdbif) beyond tasks[ntasks_init-1] */
+  pip_task_t		*task_segs[PIP_TASK_SEGS_MAX];
+  struct pip_gdbif_task	*gdbif_segs[PIP_TASK_SEGS_MAX];
+  pip_spawn_stats_t	stats;	/* updated atomically, no lock */
+  uint64_t		stats_tick0; /* to calibrate the ticks */
+  struct timespec	stats_ts0;
+  /* named export registry, updated lock-free */
+  pip_named_export_t	*named;
+  volatile uint32_t	named_seq; /* futex word, bumped at every export */
+  /* bitmap of the occupied task slots, updated lock-free */
+  volatile uint64_t	task_slots[PIP_TASK_SLOT_WORDS];
   pip_task_t		tasks[];
 } pip_root_t;
 
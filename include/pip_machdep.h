@@ -129,6 +129,15 @@ inline static int pip_spin_destroy (pip_spinlock_t *lock) {
 }
 #endif
 
+#ifndef PIP_GETTICK
+#include <time.h>
+inline static uint64_t pip_gettick( void ) {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
 #ifndef PIP_PRINT_FSREG
 inline static void pip_print_fs_segreg( void ) {}
 #endif
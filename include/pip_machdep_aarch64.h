@@ -58,6 +58,13 @@ inline static void pip_memory_barrier(void) {
 }
 #define PIP_MEMORY_BARRIER
 
+inline static uint64_t pip_gettick( void ) {
+  uint64_t tick;
+  asm volatile( "mrs %0, cntvct_el0" : "=r" (tick) );
+  return tick;
+}
+#define PIP_GETTICK
+
 inline static void pip_print_fs_segreg( void ) {
   register unsigned long result asm ("x0");
   asm ("mrs %0, tpidr_el0; " : "=r" (result));
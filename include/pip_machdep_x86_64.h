@@ -66,6 +66,13 @@ inline static void pip_memory_barrier(void) {
 }
 #define PIP_MEMORY_BARRIER
 
+inline static uint64_t pip_gettick( void ) {
+  uint32_t lo, hi;
+  asm volatile( "rdtsc" : "=a" (lo), "=d" (hi) );
+  return ( (uint64_t) hi << 32 ) | lo;
+}
+#define PIP_GETTICK
+
 #include <asm/prctl.h>
 #include <sys/prctl.h>
 #include <errno.h>
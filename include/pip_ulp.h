@@ -110,6 +110,15 @@ extern "C" {
 		      pip_ulp_termcb_t termcb,
 		      void *aux,
 		      pip_ulp_t *ulpp );
+  /* only the stack size of attr is taken (pip_spawn_attr_setstacksize) */
+  int pip_ulp_create_ex( char *prog,
+			 char **argv,
+			 char **envv,
+			 int  *pipidp,
+			 pip_ulp_termcb_t termcb,
+			 void *aux,
+			 pip_ulp_t *ulpp,
+			 pip_spawn_attr_t *attr );
   int pip_make_ulp( int pipid,
 		    pip_ulp_termcb_t termcb,
 		    void *aux,
@@ -57,30 +57,11 @@
 //#define PRINT_MAPS
 //#define PRINT_FDS
 
-/* the EVAL env. is to measure the time for calling dlmopen() */
-//#define EVAL
-
 #define PIP_INTERNAL_FUNCS
 #include <pip.h>
 #include <pip_util.h>
 #include <pip_gdbif.h>
 
-#ifdef EVAL
-
-#define ES(V,F)		\
-  do { double __st=pip_gettime(); (F); (V) += pip_gettime()-__st; } while(0)
-double time_dlmopen   = 0.0;
-double time_load_dso  = 0.0;
-double time_load_prog = 0.0;
-#define REPORT(V)	 printf( "%s: %g\n", #V, V );
-
-#else
-
-#define ES(V,F)		(F)
-#define REPORT(V)
-
-#endif
-
 extern char 		**environ;
 
 /*** note that the following static variables are   ***/
@@ -89,6 +70,29 @@ static pip_root_t	*pip_root = NULL;
 static pip_task_t	*pip_task = NULL;
 static pip_ulp_t	*pip_ulp  = NULL;
 
+/* latency of the spawn phases, see pip_get_spawn_stats() */
+static void pip_stats_add( int phase, uint64_t ticks ) {
+  pip_phase_stats_t	*ps = &pip_root->stats.phase[phase];
+  uint64_t		old;
+  int			bin;
+
+  bin = ( ticks == 0 ) ? 0 : 63 - __builtin_clzll( ticks );
+  if( bin >= PIP_SPAWN_STATS_NBINS ) bin = PIP_SPAWN_STATS_NBINS - 1;
+  (void) __sync_fetch_and_add( &ps->hist[bin], 1 );
+  (void) __sync_fetch_and_add( &ps->sum,       ticks );
+  (void) __sync_fetch_and_add( &ps->count,     1 );
+  while( ( old = ps->min ) == 0 || ticks < old ) {
+    if( __sync_bool_compare_and_swap( &ps->min, old, ticks ) ) break;
+  }
+  while( ticks > ( old = ps->max ) ) {
+    if( __sync_bool_compare_and_swap( &ps->max, old, ticks ) ) break;
+  }
+}
+
+#define PIP_PHASE(P,F)						\
+  do { uint64_t __st = pip_gettick(); (F);			\
+    pip_stats_add( (P), pip_gettick() - __st ); } while(0)
+
 static pip_clone_t*	pip_cloneinfo = NULL;
 
 static int (*pip_clone_mostly_pthread_ptr) (
@@ -100,6 +104,11 @@ static int (*pip_clone_mostly_pthread_ptr) (
 	void *arg,
 	pid_t *pidp) = NULL;
 
+/* ld.so and libc internals used by the process:clone mode */
+static void *(*pip_dl_allocate_tls_ptr)   ( void* ) = NULL;
+static void  (*pip_dl_deallocate_tls_ptr) ( void*, int ) = NULL;
+static uint32_t	*pip_thread_db_tid = NULL;  /* { bits, count, offset } */
+
 struct pip_gdbif_root	*pip_gdbif_root;
 
 int pip_root_p_( void ) {
@@ -156,6 +165,33 @@ static void pip_err_mesg( char *format, ... ) {
   pip_message( "PIP-ERROR%s:", format, ap );
 }
 
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <limits.h>
+
+static pid_t pip_gettid( void ) {
+  return (pid_t) syscall( (long int) SYS_gettid );
+}
+
+/* tasks in the process mode share the address space but not the */
+/* mm_struct, so that FUTEX_PRIVATE_FLAG must not be used here    */
+static void pip_futex_wait( volatile uint32_t *addr, uint32_t val ) {
+  (void) syscall( SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0 );
+}
+
+static int pip_futex_timedwait( volatile uint32_t *addr, uint32_t val,
+				const struct timespec *timeout ) {
+  if( syscall( SYS_futex, addr, FUTEX_WAIT, val, timeout, NULL, 0 ) != 0 ) {
+    return errno;
+  }
+  return 0;
+}
+
+static void pip_futex_wake( volatile uint32_t *addr ) {
+  (void) syscall( SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+}
+
 static int pip_count_vec( char **vecsrc ) {
   int n;
 
@@ -228,6 +264,15 @@ static void pip_init_task_struct( pip_task_t *taskp ) {
   taskp->type  = PIP_TYPE_NONE;
 }
 
+/* the task entry of pipid (0 <= pipid < ntasks), O(1) */
+static pip_task_t *pip_task_at( int pipid ) {
+  int idx;
+
+  if( pipid < pip_root->ntasks_init ) return &pip_root->tasks[pipid];
+  idx = pipid - pip_root->ntasks_init;
+  return &pip_root->task_segs[idx/PIP_TASK_SEG_SZ][idx%PIP_TASK_SEG_SZ];
+}
+
 static int pipid_to_gdbif( int pipid ) {
   switch( pipid ) {
   case PIP_PIPID_ROOT:
@@ -284,10 +329,11 @@ static void pip_link_gdbif_task_struct(	struct pip_gdbif_task *gdbif_task) {
  * because this function is only for PIP-gdb,
  * this does not return any error, but warn.
  */
-static void pip_load_gdbif( pip_task_t *task ) {
+static void pip_load_gdbif( pip_task_t *task, pip_image_t *image ) {
   struct pip_gdbif_task *gdbif_task = task->gdbif_task;
   Dl_info dli;
   char buf[PATH_MAX];
+  char *path;
 
   gdbif_task->handle = task->loaded;
 
@@ -301,13 +347,18 @@ static void pip_load_gdbif( pip_task_t *task ) {
   }
 
   /* dli.dli_fname is same with task->args.prog and may be a relative path */
-  if( realpath( task->args.prog, buf ) == NULL ) {
+  if( image != NULL && image->realpath != NULL ) {
+    path = image->realpath;
+  } else {
+    path = realpath( task->args.prog, buf );
+  }
+  if( path == NULL ) {
     gdbif_task->realpathname = NULL; /* give up */
     pip_warn_mesg( "realpath(%s): %s"
 		   " - PIP-gdb won't work with this PiP task %d",
 		   task->args.prog, strerror( errno ), task->pipid );
   } else {
-    gdbif_task->realpathname = strdup( buf );
+    gdbif_task->realpathname = strdup( path );
     if( gdbif_task->realpathname == NULL ) { /* give up */
       pip_warn_mesg( "strdup(%s) failure"
 		     " - PIP-gdb won't work with this PiP task %d",
@@ -344,6 +395,45 @@ static int pip_check_pie( char *path ) {
   return err;
 }
 
+/* find the PIP_SHARED_SECTION section of the program, if any */
+static void pip_shared_section( char *path, uintptr_t *offp, size_t *sizep ) {
+  Elf64_Ehdr elfh;
+  Elf64_Shdr *shdrs = NULL;
+  char *names = NULL;
+  size_t sz;
+  int fd, i;
+
+  *offp  = 0;
+  *sizep = 0;
+  if( ( fd = open( path, O_RDONLY ) ) < 0 ) return;
+  if( read( fd, &elfh, sizeof( elfh ) ) != sizeof( elfh ) ||
+      elfh.e_shoff == 0 ||
+      elfh.e_shentsize != sizeof( Elf64_Shdr ) ||
+      elfh.e_shstrndx >= elfh.e_shnum ) goto done;
+  sz = sizeof( Elf64_Shdr ) * elfh.e_shnum;
+  if( ( shdrs = (Elf64_Shdr*) malloc( sz ) ) == NULL ) goto done;
+  if( pread( fd, shdrs, sz, elfh.e_shoff ) != (ssize_t) sz ) goto done;
+  sz = shdrs[elfh.e_shstrndx].sh_size;
+  if( ( names = (char*) malloc( sz + 1 ) ) == NULL ) goto done;
+  if( pread( fd, names, sz, shdrs[elfh.e_shstrndx].sh_offset ) !=
+      (ssize_t) sz ) goto done;
+  names[sz] = '\0';
+  for( i=0; i<elfh.e_shnum; i++ ) {
+    if( shdrs[i].sh_name >= sz ) continue;
+    if( strcmp( &names[shdrs[i].sh_name], PIP_SHARED_SECTION ) != 0 ) continue;
+    if( !( shdrs[i].sh_flags & SHF_ALLOC ) ) break;
+    *offp  = shdrs[i].sh_addr;
+    *sizep = shdrs[i].sh_size;
+    DBGF( "%s: %s@%p (%lu)", path, PIP_SHARED_SECTION,
+	  (void*) *offp, (unsigned long) *sizep );
+    break;
+  }
+ done:
+  free( names );
+  free( shdrs );
+  (void) close( fd );
+}
+
 const char *pip_get_mode_str( void ) {
   char *mode;
 
@@ -361,6 +451,9 @@ const char *pip_get_mode_str( void ) {
   case PIP_MODE_PROCESS_PIPCLONE:
     mode = PIP_ENV_MODE_PROCESS_PIPCLONE;
     break;
+  case PIP_MODE_PROCESS_CLONE:
+    mode = PIP_ENV_MODE_PROCESS_CLONE;
+    break;
   default:
     mode = "(unknown)";
   }
@@ -390,6 +483,32 @@ static void pip_dlclose( void *handle ) {
 #endif
 }
 
+/* process:clone mode needs neither the patched glibc nor LD_PRELOAD. */
+/* The root calls clone() by itself with a TLS block allocated by     */
+/* ld.so, so that the TLS variables of the already loaded namespaces  */
+/* are set up in the new process as they are in a new pthread.        */
+static int pip_clone_direct_p( void ) {
+#ifdef __x86_64__
+  if( pip_dl_allocate_tls_ptr == NULL ) {
+    pip_dl_allocate_tls_ptr =
+      dlvsym( RTLD_DEFAULT, "_dl_allocate_tls", "GLIBC_PRIVATE" );
+    pip_dl_deallocate_tls_ptr =
+      dlvsym( RTLD_DEFAULT, "_dl_deallocate_tls", "GLIBC_PRIVATE" );
+    /* the offset of the tid field in struct pthread, for libthread_db */
+    pip_thread_db_tid =
+      dlvsym( RTLD_DEFAULT, "_thread_db_pthread_tid", "GLIBC_PRIVATE" );
+  }
+  DBGF( "_dl_allocate_tls@%p  _dl_deallocate_tls@%p  _thread_db_pthread_tid@%p",
+	pip_dl_allocate_tls_ptr, pip_dl_deallocate_tls_ptr, pip_thread_db_tid );
+  return( pip_dl_allocate_tls_ptr   != NULL &&
+	  pip_dl_deallocate_tls_ptr != NULL &&
+	  pip_thread_db_tid         != NULL );
+#else
+  /* the TCB layout below is x86_64 specific */
+  return 0;
+#endif
+}
+
 static int pip_check_opt_and_env( int *optsp ) {
   int opts   = *optsp;
   int mode   = ( opts & PIP_MODE_MASK );
@@ -399,7 +518,8 @@ static int pip_check_opt_and_env( int *optsp ) {
   enum PIP_MODE_BITS {
     PIP_MODE_PTHREAD_BIT          = 1,
     PIP_MODE_PROCESS_PRELOAD_BIT  = 2,
-    PIP_MODE_PROCESS_PIPCLONE_BIT = 4
+    PIP_MODE_PROCESS_PIPCLONE_BIT = 4,
+    PIP_MODE_PROCESS_CLONE_BIT    = 8
   } desired = 0;
 
   if( ( opts & ~PIP_VALID_OPTS ) != 0 ) {
@@ -410,10 +530,14 @@ static int pip_check_opt_and_env( int *optsp ) {
   if( opts & PIP_MODE_PTHREAD &&
       opts & PIP_MODE_PROCESS ) RETURN( EINVAL );
   if( opts & PIP_MODE_PROCESS ) {
-    if( ( opts & PIP_MODE_PROCESS_PRELOAD  ) == PIP_MODE_PROCESS_PRELOAD &&
-	( opts & PIP_MODE_PROCESS_PIPCLONE ) == PIP_MODE_PROCESS_PIPCLONE){
-      RETURN (EINVAL );
-    }
+    int nsub = 0;
+    if( ( opts & PIP_MODE_PROCESS_PRELOAD  ) == PIP_MODE_PROCESS_PRELOAD  )
+      nsub ++;
+    if( ( opts & PIP_MODE_PROCESS_PIPCLONE ) == PIP_MODE_PROCESS_PIPCLONE )
+      nsub ++;
+    if( ( opts & PIP_MODE_PROCESS_CLONE    ) == PIP_MODE_PROCESS_CLONE    )
+      nsub ++;
+    if( nsub > 1 ) RETURN (EINVAL );
   }
 
   switch( mode ) {
@@ -434,6 +558,8 @@ static int pip_check_opt_and_env( int *optsp ) {
       desired = PIP_MODE_PROCESS_PRELOAD_BIT;
     } else if( strcasecmp( env, PIP_ENV_MODE_PROCESS_PIPCLONE ) == 0 ) {
       desired = PIP_MODE_PROCESS_PIPCLONE_BIT;
+    } else if( strcasecmp( env, PIP_ENV_MODE_PROCESS_CLONE    ) == 0 ) {
+      desired = PIP_MODE_PROCESS_CLONE_BIT;
     } else {
       pip_warn_mesg( "unknown environment setting PIP_MODE='%s'", env );
       RETURN( EPERM );
@@ -451,6 +577,8 @@ static int pip_check_opt_and_env( int *optsp ) {
       desired = PIP_MODE_PROCESS_PRELOAD_BIT;
     } else if( strcasecmp( env, PIP_ENV_MODE_PROCESS_PIPCLONE ) == 0 ) {
       desired = PIP_MODE_PROCESS_PIPCLONE_BIT;
+    } else if( strcasecmp( env, PIP_ENV_MODE_PROCESS_CLONE    ) == 0 ) {
+      desired = PIP_MODE_PROCESS_CLONE_BIT;
     } else if( strcasecmp( env, PIP_ENV_MODE_THREAD  ) == 0 ||
 	       strcasecmp( env, PIP_ENV_MODE_PTHREAD ) == 0 ||
 	       strcasecmp( env, PIP_ENV_MODE_PROCESS ) == 0 ) {
@@ -469,6 +597,9 @@ static int pip_check_opt_and_env( int *optsp ) {
   case PIP_MODE_PROCESS_PIPCLONE:
     desired = PIP_MODE_PROCESS_PIPCLONE_BIT;
     break;
+  case PIP_MODE_PROCESS_CLONE:
+    desired = PIP_MODE_PROCESS_CLONE_BIT;
+    break;
   default:
     pip_warn_mesg( "pip_init() invalid argument opts=0x%x", opts );
     RETURN( EINVAL );
@@ -517,6 +648,16 @@ static int pip_check_opt_and_env( int *optsp ) {
       RETURN( EPERM );
     }
   }
+  if( desired & PIP_MODE_PROCESS_CLONE_BIT ) {
+    /* never chosen implicitly, only when it is asked for by name */
+    if( pip_clone_direct_p() ) {
+      newmod = PIP_MODE_PROCESS_CLONE;
+      goto done;
+    }
+    pip_warn_mesg( "process:clone mode is requested but "
+		   "it is not supported on this platform" );
+    RETURN( EPERM );
+  }
   if( desired & PIP_MODE_PTHREAD_BIT ) {
     newmod = PIP_MODE_PTHREAD;
     goto done;
@@ -528,22 +669,48 @@ static int pip_check_opt_and_env( int *optsp ) {
  done:
   if( ( opts & ~PIP_MODE_MASK ) == 0 ) {
     if( ( env = getenv( PIP_ENV_OPTS ) ) != NULL ) {
-      if( strcasecmp( env, PIP_ENV_OPTS_FORCEEXIT ) == 0 ) {
-	opts |= PIP_OPT_FORCEEXIT;
-      } else {
-	pip_warn_mesg( "Unknown option %s=%s", PIP_ENV_OPTS, env );
-	RETURN( EPERM );
+      /* comma separated list of the options */
+      char *list, *opt, *save;
+
+      if( ( list = strdup( env ) ) == NULL ) RETURN( ENOMEM );
+      for( opt = strtok_r( list, ",", &save );
+	   opt != NULL;
+	   opt = strtok_r( NULL, ",", &save ) ) {
+	if( strcasecmp( opt, PIP_ENV_OPTS_FORCEEXIT ) == 0 ) {
+	  opts |= PIP_OPT_FORCEEXIT;
+	} else if( strcasecmp( opt, PIP_ENV_OPTS_RECYCLE ) == 0 ) {
+	  opts |= PIP_OPT_RECYCLE;
+	} else if( strcasecmp( opt, PIP_ENV_OPTS_ULPSHARE_EXPERIMENTAL ) == 0 ) {
+	  opts |= PIP_OPT_ULPSHARE_EXPERIMENTAL;
+	} else if( strcasecmp( opt, PIP_ENV_OPTS_SHAREENV ) == 0 ) {
+	  opts |= PIP_OPT_SHAREENV;
+	} else if( strcasecmp( opt, PIP_ENV_OPTS_NUMABIND ) == 0 ) {
+	  opts |= PIP_OPT_NUMABIND;
+	} else if( strcasecmp( opt, PIP_ENV_OPTS_HUGEPAGE ) == 0 ) {
+	  opts |= PIP_OPT_HUGEPAGE;
+	} else {
+	  pip_warn_mesg( "Unknown option %s=%s", PIP_ENV_OPTS, env );
+	  free( list );
+	  RETURN( EPERM );
+	}
       }
+      free( list );
     }
   }
   *optsp = ( opts & ~PIP_MODE_MASK ) | newmod;
   RETURN( 0 );
 }
 
+static pip_shared_table_t *pip_shared_table_new( void*, uintptr_t, size_t );
+static void pip_shared_resolve_tls( pip_shared_table_t* );
+
 int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
   size_t	sz;
+  uintptr_t	shared_off;
+  size_t	shared_size;
   char		*envroot = NULL;
   char		*envtask = NULL;
+  char		*env;
   int		ntasks;
   int 		pipid;
   int 		i, err = 0;
@@ -555,15 +722,18 @@ int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
     /* root process ? */
 
     if( ntasksp == NULL ) {
-      ntasks = PIP_NTASKS_MAX;
+      /* start small, the table grows up to the limit on demand */
+      ntasks = PIP_TASK_SEG_SZ;
     } else if( *ntasksp <= 0 ) {
       RETURN( EINVAL );
     } else {
       ntasks = *ntasksp;
     }
-    if( ntasks > PIP_NTASKS_MAX ) RETURN( EOVERFLOW );
-
     if( ( err = pip_check_opt_and_env( &opts ) ) != 0 ) RETURN( err );
+    if( ntasks > ( ( opts & PIP_OPT_ULPSHARE_EXPERIMENTAL ) ?
+		   PIP_NTASKS_MAX_ULPSHARE : PIP_NTASKS_MAX ) ) {
+      RETURN( EOVERFLOW );
+    }
 
     sz = sizeof( pip_root_t ) + sizeof( pip_task_t ) * ( ntasks + 1 );
     if( ( err = pip_page_alloc( sz, (void**) &pip_root ) ) != 0 ) {
@@ -578,6 +748,8 @@ int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
 
     pip_spin_init( &pip_root->lock_ldlinux     );
     pip_spin_init( &pip_root->lock_stack_flist );
+    pip_spin_init( &pip_root->lock_pool        );
+    pip_spin_init( &pip_root->lock_images      );
     pip_spin_init( &pip_root->lock_tasks       );
     /* beyond this point, we can call the       */
     /* pip_dlsymc() and pip_dlclose() functions */
@@ -585,11 +757,24 @@ int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
     pipid = PIP_PIPID_ROOT;
     pip_set_magic( pip_root );
     pip_root->version   = PIP_VERSION;
-    pip_root->ntasks    = ntasks;
+    pip_root->ntasks      = ntasks;
+    pip_root->ntasks_init = ntasks;
+    if( ntasksp == NULL ) {
+      pip_root->ntasks_max = ( opts & PIP_OPT_ULPSHARE_EXPERIMENTAL ) ?
+	PIP_NTASKS_MAX_ULPSHARE : PIP_NTASKS_MAX;
+    } else {
+      pip_root->ntasks_max = ntasks;
+    }
     pip_root->cloneinfo = pip_cloneinfo;
     pip_root->opts      = opts;
     pip_root->page_size = sysconf( _SC_PAGESIZE );
     pip_root->task_root = &pip_root->tasks[ntasks];
+    pip_root->stats_tick0 = pip_gettick();
+    (void) clock_gettime( CLOCK_MONOTONIC, &pip_root->stats_ts0 );
+    pip_root->pool_max  = ntasks;
+    if( ( env = getenv( PIP_ENV_POOL_MAX ) ) != NULL && *env != '\0' ) {
+      pip_root->pool_max = (int) strtol( env, NULL, 10 );
+    }
     for( i=0; i<ntasks+1; i++ ) {
       pip_init_task_struct( &pip_root->tasks[i] );
     }
@@ -599,12 +784,24 @@ int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
       pip_dlsym( RTLD_DEFAULT, "pip_pthread_add_stack_user");
     pip_root->task_root->symbols.free      = (free_t) pip_dlsym( RTLD_DEFAULT, "free");
     pip_root->task_root->loaded            = dlopen( NULL, RTLD_NOW );
+    pip_shared_section( "/proc/self/exe", &shared_off, &shared_size );
+    pip_root->task_root->shared =
+      pip_shared_table_new( pip_root->task_root->loaded,
+			    shared_off, shared_size );
+    pip_shared_resolve_tls( pip_root->task_root->shared );
     pip_root->task_root->thread            = pthread_self();
     pip_root->task_root->pid               = getpid();
     if( rt_expp != NULL ) {
       pip_root->task_root->export          = *rt_expp;
     }
     pip_spin_init( &pip_root->task_root->lock_malloc );
+    if( ( err = pip_page_alloc( sizeof(pip_named_export_t) *
+				PIP_NAMED_EXPORT_MAX,
+				(void**) &pip_root->named ) ) != 0 ) {
+      RETURN( err );
+    }
+    memset( pip_root->named, 0,
+	    sizeof(pip_named_export_t) * PIP_NAMED_EXPORT_MAX );
     unsetenv( PIP_ROOT_ENV );
 
     sz = sizeof( *gdbif_root ) + sizeof( gdbif_root->tasks[0] ) * ntasks;
@@ -632,7 +829,7 @@ int pip_init( int *pipidp, int *ntasksp, void **rt_expp, int opts ) {
       pip_err_mesg( "Invalid PiP task (pipid=%d)" );
       RETURN( EPERM );
     }
-    pip_task = &pip_root->tasks[pipid];
+    pip_task = pip_task_at( pipid );
     ntasks = pip_root->ntasks;
     if( ntasksp != NULL ) *ntasksp = ntasks;
     if( rt_expp != NULL ) *rt_expp = (void*) pip_root->task_root->export;
@@ -726,7 +923,7 @@ static pip_task_t *pip_get_task_( int pipid ) {
     break;
   default:
     if( pipid >= 0 && pipid < pip_root->ntasks ) {
-      task = &pip_root->tasks[pipid];
+      task = pip_task_at( pipid );
     }
     break;
   }
@@ -803,27 +1000,272 @@ int pip_import( int pipid, void **exportp  ) {
   RETURN( 0 );
 }
 
+/* named export registry */
+
+static uint64_t pip_name_hash( const char *name ) {
+  uint64_t hash = 14695981039346656037UL; /* FNV-1a */
+
+  for( ; *name != '\0'; name++ ) {
+    hash ^= (unsigned char) *name;
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}
+
+/* the same name exported by many tasks must not make one long chain */
+static uint64_t pip_named_hash( int pipid, const char *name ) {
+  uint64_t hash = pip_name_hash( name );
+  int i;
+
+  for( i=0; i<(int) sizeof(pipid); i++ ) {
+    hash ^= (unsigned char) ( pipid >> ( i * 8 ) );
+    hash *= 1099511628211UL;
+  }
+  return hash;
+}
+
+#define PIP_NAMED_ENTRY(H,I)	\
+  (&pip_root->named[ ( (H) + (I) ) & ( PIP_NAMED_EXPORT_MAX - 1 ) ])
+
+/* the probe sequence ends at an empty entry, never made empty again */
+static pip_named_export_t *pip_named_find( int pipid,
+					   const char *name,
+					   uint64_t hash ) {
+  pip_named_export_t *ent;
+  uint32_t state;
+  int i;
+
+  for( i=0; i<PIP_NAMED_EXPORT_MAX; i++ ) {
+    ent   = PIP_NAMED_ENTRY( hash, i );
+    state = ent->state;
+    if( state == PIP_NAMED_EMPTY ) break;
+    if( state != PIP_NAMED_READY ) continue;
+    pip_memory_barrier();
+    if( ent->pipid == pipid &&
+	ent->hash  == hash  &&
+	strcmp( ent->name, name ) == 0 ) return ent;
+  }
+  return NULL;
+}
+
+int pip_named_export( const char *name, void *addr, size_t size ) {
+  pip_named_export_t *ent;
+  uint64_t	hash;
+  uint32_t	state;
+  int		pipid, i;
+
+  if( pip_root == NULL ) RETURN( EPERM  );
+  if( name     == NULL ) RETURN( EINVAL );
+  if( strlen( name ) >= PIP_NAMED_EXPORT_NAMELEN ) RETURN( EINVAL );
+
+  pipid = pip_get_pipid_();
+  hash  = pip_named_hash( pipid, name );
+  if( pip_named_find( pipid, name, hash ) != NULL ) RETURN( EBUSY );
+  for( i=0; i<PIP_NAMED_EXPORT_MAX; i++ ) {
+    ent   = PIP_NAMED_ENTRY( hash, i );
+    state = ent->state;
+    if( state != PIP_NAMED_EMPTY && state != PIP_NAMED_DEAD ) continue;
+    if( !__sync_bool_compare_and_swap( &ent->state, state, PIP_NAMED_BUSY ) ) {
+      i --;			/* taken by the other, look at it again */
+      continue;
+    }
+    ent->pipid = pipid;
+    ent->hash  = hash;
+    ent->addr  = addr;
+    ent->size  = size;
+    strcpy( ent->name, name );
+    pip_memory_barrier();
+    ent->state = PIP_NAMED_READY;
+    (void) __sync_fetch_and_add( &pip_root->named_seq, 1 );
+    pip_futex_wake( &pip_root->named_seq );
+    RETURN( 0 );
+  }
+  RETURN( ENOSPC );
+}
+
+int pip_named_import( int pipid, const char *name, void **addrp,
+		      size_t *sizep, const struct timespec *timeout ) {
+  pip_named_export_t *ent;
+  struct timespec now, deadline, remain;
+  uint64_t	hash;
+  uint32_t	seq;
+  int		err;
+
+  if( pip_root == NULL                 ) RETURN( EPERM  );
+  if( name == NULL || addrp == NULL    ) RETURN( EINVAL );
+  /* the task table may not be grown to the pipid yet, wait for it */
+  if( pipid < pip_root->ntasks || pipid >= pip_root->ntasks_max ) {
+    if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
+  }
+
+  if( timeout != NULL ) {
+    (void) clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec  += timeout->tv_sec;
+    deadline.tv_nsec += timeout->tv_nsec;
+    if( deadline.tv_nsec >= 1000000000L ) {
+      deadline.tv_sec  ++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+  hash = pip_named_hash( pipid, name );
+  while( 1 ) {
+    /* read the sequence first not to miss the wake-up */
+    seq = pip_root->named_seq;
+    pip_memory_barrier();
+    if( ( ent = pip_named_find( pipid, name, hash ) ) != NULL ) {
+      *addrp = ent->addr;
+      if( sizep != NULL ) *sizep = ent->size;
+      RETURN( 0 );
+    }
+    if( timeout == NULL ) {
+      (void) pip_futex_timedwait( &pip_root->named_seq, seq, NULL );
+    } else {
+      (void) clock_gettime( CLOCK_MONOTONIC, &now );
+      remain.tv_sec  = deadline.tv_sec  - now.tv_sec;
+      remain.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+      if( remain.tv_nsec < 0 ) {
+	remain.tv_sec  --;
+	remain.tv_nsec += 1000000000L;
+      }
+      if( remain.tv_sec < 0 ) RETURN( ETIMEDOUT );
+      (void) pip_futex_timedwait( &pip_root->named_seq, seq, &remain );
+    }
+  }
+}
+
+/* the regions exported by a terminated task */
+static void pip_named_export_fin( int pipid ) {
+  pip_named_export_t *ent;
+  int i;
+
+  if( pip_root->named == NULL ) return;
+  for( i=0; i<PIP_NAMED_EXPORT_MAX; i++ ) {
+    ent = &pip_root->named[i];
+    if( ent->state == PIP_NAMED_READY && ent->pipid == pipid ) {
+      ent->state = PIP_NAMED_DEAD;
+    }
+  }
+}
+
+/* symbol address cache of a task, looked up without any lock */
+
+#define PIP_SYMCACHE_ENTRY(T,H,I)	\
+  (&(T)->symcache[ ( (H) + (I) ) & ( PIP_SYMCACHE_SZ - 1 ) ])
+
+static void *pip_symcache_find( pip_task_t *task,
+				const char *name,
+				uint64_t hash ) {
+  pip_symcache_t *ent;
+  uint32_t state;
+  int i;
+
+  for( i=0; i<PIP_SYMCACHE_SZ; i++ ) {
+    ent   = PIP_SYMCACHE_ENTRY( task, hash, i );
+    state = ent->state;
+    if( state == PIP_NAMED_EMPTY ) break;
+    if( state != PIP_NAMED_READY ) continue;
+    pip_memory_barrier();
+    if( ent->hash == hash && strcmp( ent->name, name ) == 0 ) return ent->addr;
+  }
+  return NULL;
+}
+
+static void pip_symcache_add( pip_task_t *task,
+			      const char *name,
+			      uint64_t hash,
+			      void *addr ) {
+  pip_symcache_t *ent;
+  int i;
+
+  if( strlen( name ) >= PIP_SYMCACHE_NAMELEN ) return;
+  for( i=0; i<PIP_SYMCACHE_SZ; i++ ) {
+    ent = PIP_SYMCACHE_ENTRY( task, hash, i );
+    if( ent->state != PIP_NAMED_EMPTY ) continue;
+    if( __sync_bool_compare_and_swap( &ent->state,
+				      PIP_NAMED_EMPTY,
+				      PIP_NAMED_BUSY ) ) {
+      ent->hash = hash;
+      ent->addr = addr;
+      strcpy( ent->name, name );
+      pip_memory_barrier();
+      ent->state = PIP_NAMED_READY;
+      return;
+    }
+  }
+  /* full, not cached */
+}
+
+static void pip_symcache_clear( pip_task_t *task ) {
+  memset( task->symcache, 0, sizeof(task->symcache) );
+  pip_memory_barrier();
+}
+
+/* must be called with lock_ldlinux held */
+static void *pip_get_addr_locked( pip_task_t *task,
+				  const char *name,
+				  uint64_t hash ) {
+  void *addr;
+
+  (void) dlerror();		/* reset error status */
+  if( ( addr = dlsym( task->loaded, name ) ) == NULL ) {
+    DBGF( "dlsym(%p,%s): %s", task->loaded, name, dlerror() );
+  } else {
+    pip_symcache_add( task, name, hash, addr );
+  }
+  return addr;
+}
+
 int pip_get_addr( int pipid, const char *name, void **addrp ) {
-  void *handle;
+  pip_task_t *task;
+  uint64_t hash;
   int err;
 
   if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
   if( name == NULL || addrp == NULL            ) RETURN( EINVAL );
   DBGF( "pipid=%d", pipid );
-  if( pipid == PIP_PIPID_ROOT ) {;
-    *addrp = pip_dlsym( pip_root->task_root->loaded, name );
-  } else if( pipid == PIP_PIPID_MYSELF ) {
-    *addrp = pip_dlsym( pip_task->loaded, name );
-  } else if( ( handle = pip_root->tasks[pipid].loaded ) != NULL ) {
-    *addrp = pip_dlsym( handle, name );
-    /* FIXME: pip_dlsym() has a lock but this does not prevent for user */
-    /*        programs to directly call dl*() functions without lock    */
-    DBGF( "=%p", *addrp );
-  } else {
+  task = pip_get_task_( pipid );
+  if( task == NULL || task->loaded == NULL ) {
     DBG;
-    err = ESRCH;		/* tentative */
+    RETURN( ESRCH );		/* tentative */
   }
-  RETURN( err );
+  hash = pip_name_hash( name );
+  if( ( *addrp = pip_symcache_find( task, name, hash ) ) != NULL ) {
+    RETURN( 0 );
+  }
+  /* FIXME: lock_ldlinux does not prevent for user programs */
+  /*        to directly call dl*() functions without lock    */
+  pip_spin_lock( &pip_root->lock_ldlinux );
+  *addrp = pip_get_addr_locked( task, name, hash );
+  pip_spin_unlock( &pip_root->lock_ldlinux );
+  DBGF( "=%p", *addrp );
+  RETURN( 0 );
+}
+
+int pip_get_addr_all( const char *name, void **addrs, int ntasks ) {
+  pip_task_t *task;
+  uint64_t hash;
+  int i, locked = 0;
+
+  if( pip_root == NULL                          ) RETURN( EPERM  );
+  if( name == NULL || addrs == NULL || ntasks < 0 ) RETURN( EINVAL );
+  hash = pip_name_hash( name );
+  for( i=0; i<ntasks; i++ ) {
+    addrs[i] = NULL;
+    if( i >= pip_root->ntasks ) continue;
+    task = pip_task_at( i );
+    if( task->loaded == NULL ) continue;
+    if( ( addrs[i] = pip_symcache_find( task, name, hash ) ) != NULL ) {
+      continue;
+    }
+    /* the lock is taken once for all the misses */
+    if( !locked ) {
+      pip_spin_lock( &pip_root->lock_ldlinux );
+      locked = 1;
+    }
+    addrs[i] = pip_get_addr_locked( task, name, hash );
+  }
+  if( locked ) pip_spin_unlock( &pip_root->lock_ldlinux );
+  RETURN( 0 );
 }
 
 static char **pip_copy_vec3( char *addition0,
@@ -891,18 +1333,204 @@ static char **pip_copy_vec( char **vecsrc ) {
   return pip_copy_vec3( NULL, NULL, NULL, vecsrc );
 }
 
-static char **pip_copy_env( char **envsrc, int pipid ) {
+/* PIP_OPT_SHAREENV: the environment strings are shared among tasks */
+
+static uint64_t pip_env_hash( char **envsrc, int *countp, size_t *sizep ) {
+  uint64_t	hash = 14695981039346656037UL; /* FNV-1a */
+  size_t	size = 0;
+  char		*p;
+  int		i;
+
+  for( i=0; envsrc[i]!=NULL; i++ ) {
+    for( p=envsrc[i]; ; p++ ) {
+      hash ^= (unsigned char) *p;
+      hash *= 1099511628211UL;
+      if( *p == '\0' ) break;
+    }
+    size += p - envsrc[i] + 1;
+  }
+  *countp = i;
+  *sizep  = size;
+  return hash;
+}
+
+static int pip_env_block_match( pip_env_block_t *block, char **envsrc ) {
+  int i;
+
+  for( i=0; i<block->count; i++ ) {
+    if( strcmp( block->vec[i], envsrc[i] ) != 0 ) return 0;
+  }
+  return 1;
+}
+
+static pip_env_block_t *pip_env_block_get( char **envsrc ) {
+  pip_env_block_t	*block;
+  uint64_t		hash;
+  size_t		size, pgsz = pip_root->page_size;
+  char			*p;
+  int			count, i;
+
+  hash = pip_env_hash( envsrc, &count, &size );
+  pip_spin_lock( &pip_root->lock_images );
+  for( block=pip_root->env_blocks; block!=NULL; block=block->next ) {
+    if( block->hash  == hash  &&
+	block->count == count &&
+	pip_env_block_match( block, envsrc ) ) {
+      block->nrefs ++;
+      break;
+    }
+  }
+  pip_spin_unlock( &pip_root->lock_images );
+  if( block != NULL ) return block;
+
+  if( ( block = (pip_env_block_t*) malloc( sizeof(*block) ) ) == NULL ) {
+    return NULL;
+  }
+  size += sizeof(char*) * ( count + 1 );
+  size  = ( ( size + pgsz - 1 ) / pgsz ) * pgsz;
+  block->vec = (char**) mmap( NULL, size, PROT_READ|PROT_WRITE,
+			      MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+  if( block->vec == MAP_FAILED ) {
+    free( block );
+    return NULL;
+  }
+  block->hash  = hash;
+  block->count = count;
+  block->nrefs = 1;
+  block->size  = size;
+  p = (char*) &block->vec[count+1];
+  for( i=0; i<count; i++ ) {
+    block->vec[i] = p;
+    p = stpcpy( p, envsrc[i] ) + 1;
+  }
+  block->vec[count] = NULL;
+  (void) mprotect( block->vec, size, PROT_READ );
+
+  pip_spin_lock( &pip_root->lock_images );
+  block->next = pip_root->env_blocks;
+  pip_root->env_blocks = block;
+  pip_spin_unlock( &pip_root->lock_images );
+  return block;
+}
+
+/* unmapped when the last task using it is finalized */
+static void pip_env_block_put( pip_env_block_t *block ) {
+  pip_env_block_t **pp;
+  int nrefs;
+
+  pip_spin_lock( &pip_root->lock_images );
+  /*** begin lock region ***/
+  if( ( nrefs = -- block->nrefs ) == 0 ) {
+    for( pp=&pip_root->env_blocks; *pp!=NULL; pp=&(*pp)->next ) {
+      if( *pp == block ) {
+	*pp = block->next;
+	break;
+      }
+    }
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_images );
+  if( nrefs == 0 ) {
+    (void) munmap( block->vec, block->size );
+    free( block );
+  }
+}
+
+static void pip_env_block_fin( void ) {
+  pip_env_block_t *block, *next;
+
+  for( block=pip_root->env_blocks; block!=NULL; block=next ) {
+    next = block->next;
+    (void) munmap( block->vec, block->size );
+    free( block );
+  }
+  pip_root->env_blocks = NULL;
+}
+
+/* only the array and the PiP variables are allocated for a task */
+static char **pip_env_block_vec( pip_env_block_t *block,
+				 char *rootenv,
+				 char *taskenv ) {
+  char		**vecdst, *p;
+  size_t	sz;
+  int		n = block->count;
+
+  sz = sizeof(char*) * ( n + 3 ) + strlen( rootenv ) + strlen( taskenv ) + 2;
+  if( ( vecdst = (char**) malloc( sz ) ) == NULL ) return NULL;
+  p = (char*) &vecdst[n+3];
+  vecdst[0] = p;
+  p = stpcpy( p, rootenv ) + 1;
+  vecdst[1] = p;
+  (void) stpcpy( p, taskenv );
+  memcpy( &vecdst[2], block->vec, sizeof(char*) * n );
+  vecdst[n+2] = NULL;
+  return vecdst;
+}
+
+static char **pip_share_env( char *rootenv,
+			     char *taskenv,
+			     char **envsrc,
+			     pip_env_block_t **blockp ) {
+  pip_env_block_t	*block;
+  char			**vecdst;
+
+  if( ( block = pip_env_block_get( envsrc ) ) == NULL ) return NULL;
+  if( ( vecdst = pip_env_block_vec( block, rootenv, taskenv ) ) == NULL ) {
+    pip_env_block_put( block );
+    return NULL;
+  }
+  *blockp = block;
+  return vecdst;
+}
+
+static int pip_env_names( char *rootenv, char *taskenv, int pipid ) {
+  return sprintf( rootenv, "%s=%p", PIP_ROOT_ENV, pip_root ) <= 0 ||
+	 sprintf( taskenv, "%s=%d", PIP_TASK_ENV, pipid    ) <= 0;
+}
+
+static char **pip_copy_env( char **envsrc,
+			    int pipid,
+			    pip_env_block_t **blockp ) {
   char rootenv[128];
   char taskenv[128];
   char *preload_env = getenv( "LD_PRELOAD" );
 
-  if( sprintf( rootenv, "%s=%p", PIP_ROOT_ENV, pip_root ) <= 0 ||
-      sprintf( taskenv, "%s=%d", PIP_TASK_ENV, pipid    ) <= 0 ) {
-    return NULL;
+  *blockp = NULL;
+  if( pip_env_names( rootenv, taskenv, pipid ) ) return NULL;
+  if( pip_root->opts & PIP_OPT_SHAREENV ) {
+    return pip_share_env( rootenv, taskenv, envsrc, blockp );
   }
   return pip_copy_vec3( rootenv, taskenv, preload_env, envsrc );
 }
 
+/* pip_spawn_n(): the tasks of a batch use the block of the batch */
+static char **pip_copy_env_block( pip_env_block_t *block,
+				  int pipid,
+				  pip_env_block_t **blockp ) {
+  char rootenv[128];
+  char taskenv[128];
+  char **vecdst;
+
+  *blockp = NULL;
+  if( pip_env_names( rootenv, taskenv, pipid ) ) return NULL;
+  pip_spin_lock( &pip_root->lock_images );
+  block->nrefs ++;
+  pip_spin_unlock( &pip_root->lock_images );
+  if( ( vecdst = pip_env_block_vec( block, rootenv, taskenv ) ) == NULL ) {
+    pip_env_block_put( block );
+    return NULL;
+  }
+  *blockp = block;
+  return vecdst;
+}
+
+static void pip_free_env( pip_spawn_args_t *args ) {
+  if( args->envv   != NULL ) free( args->envv );
+  if( args->envblk != NULL ) pip_env_block_put( args->envblk );
+  args->envv   = NULL;
+  args->envblk = NULL;
+}
+
 static size_t pip_stack_size( void ) {
   char 		*env, *endptr;
   size_t 	sz, scale;
@@ -981,6 +1609,95 @@ static void pip_close_on_exec( void ) {
 #endif
 }
 
+static int pip_closefrom( int lowfd ) {
+  DIR *dir;
+  struct dirent *direntp;
+  int fd;
+
+#ifdef SYS_close_range
+  if( syscall( SYS_close_range, lowfd, ~0U, 0 ) == 0 ) return 0;
+  if( errno != ENOSYS ) return errno;
+#endif
+  if( ( dir = opendir( PROCFD_PATH ) ) == NULL ) return errno;
+  {
+    int fd_dir = dirfd( dir );
+    while( ( direntp = readdir( dir ) ) != NULL ) {
+      if( direntp->d_name[0] == '.' ) continue;
+      if( ( fd = atoi( direntp->d_name ) ) >= lowfd && fd != fd_dir ) {
+	(void) close( fd );
+      }
+    }
+  }
+  (void) closedir( dir );
+  return 0;
+}
+
+static void pip_spawn_attr_free( pip_spawn_attr_t *attr ) {
+  free( attr->actions );
+  free( attr->cpuset );
+  free( attr->mpol_nodemask );
+  memset( attr, 0, sizeof(pip_spawn_attr_t) );
+}
+
+static void *pip_dup_mem( void *src, size_t sz ) {
+  void *dst;
+  if( src == NULL || sz == 0 ) return NULL;
+  if( ( dst = malloc( sz ) ) != NULL ) memcpy( dst, src, sz );
+  return dst;
+}
+
+static size_t pip_nodemask_size( unsigned long maxnode ) {
+  size_t bits = sizeof(unsigned long) * 8;
+  return ( ( maxnode + bits - 1 ) / bits ) * sizeof(unsigned long);
+}
+
+static int pip_spawn_attr_copy( pip_spawn_attr_t *dst, pip_spawn_attr_t *src ) {
+  *dst = *src;
+  dst->actions = pip_dup_mem( src->actions,
+			      sizeof(pip_file_action_t) * src->nactions );
+  dst->cpuset  = pip_dup_mem( src->cpuset, src->cpusetsize );
+  dst->mpol_nodemask = pip_dup_mem( src->mpol_nodemask,
+				    pip_nodemask_size( src->mpol_maxnode ) );
+  if( ( src->actions       != NULL && dst->actions       == NULL ) ||
+      ( src->cpuset        != NULL && dst->cpuset        == NULL ) ||
+      ( src->mpol_nodemask != NULL && dst->mpol_nodemask == NULL ) ) {
+    pip_spawn_attr_free( dst );
+    RETURN( ENOMEM );
+  }
+  RETURN( 0 );
+}
+
+static int pip_do_file_actions( pip_spawn_attr_t *attr ) {
+  pip_file_action_t *fa;
+  int i, err = 0;
+
+  for( i=0; i<attr->nactions && err==0; i++ ) {
+    fa = &attr->actions[i];
+    switch( fa->type ) {
+    case PIP_FILE_ACTION_CLOSE:
+      /* EBADF is ignored, as posix_spawn() does */
+      if( close( fa->fd ) != 0 && errno != EBADF ) err = errno;
+      break;
+    case PIP_FILE_ACTION_DUP2:
+      if( fa->fd == fa->newfd ) {
+	/* posix_spawn() clears FD_CLOEXEC in this case */
+	int flags = fcntl( fa->fd, F_GETFD );
+	if( flags < 0 ||
+	    fcntl( fa->fd, F_SETFD, flags & ~FD_CLOEXEC ) != 0 ) err = errno;
+      } else if( dup2( fa->fd, fa->newfd ) < 0 ) {
+	err = errno;
+      }
+      break;
+    case PIP_FILE_ACTION_CLOSEFROM:
+      err = pip_closefrom( fa->fd );
+      break;
+    default:
+      err = EINVAL;
+    }
+  }
+  RETURN( err );
+}
+
 static int pip_load_dso( void **handlep, char *path ) {
   Lmid_t	lmid;
   int 		flags = RTLD_NOW | RTLD_LOCAL;
@@ -996,7 +1713,7 @@ static int pip_load_dso( void **handlep, char *path ) {
     RETURN( ENXIO );
   }
   DBGF( "calling dlmopen(%s)", path );
-  ES( time_dlmopen, ( loaded = dlmopen( lmid, path, flags ) ) );
+  loaded = dlmopen( lmid, path, flags );
   if( pip_root->task_root->symbols.add_stack != NULL ) {
     //pip_root->task_root->symbols.add_stack();
   }
@@ -1012,28 +1729,37 @@ static int pip_load_dso( void **handlep, char *path ) {
   RETURN( 0 );
 }
 
-static int pip_find_symbols( void *handle, pip_symbols_t *symp ) {
-  int err = 0;
-
-  //if( pip_root_p() ) pip_print_dsos();
+#define PIP_SYMBOL(N,F)		{ (N), offsetof(pip_symbols_t,F) }
 
+static struct {
+  char		*name;
+  size_t	offset;
+} pip_symbol_table[] = {
   /* functions */
-  symp->main          = dlsym( handle, "main"                         );
+  PIP_SYMBOL( "main",                         main           ),
 #ifdef PIP_PTHREAD_INIT
-  symp->pthread_init  = dlsym( handle, "__pthread_initialize_minimal" );
+  PIP_SYMBOL( "__pthread_initialize_minimal", pthread_init   ),
 #endif
-  symp->ctype_init    = dlsym( handle, "__ctype_init"                 );
-  symp->glibc_init    = dlsym( handle, "glibc_init"                   );
-  symp->add_stack     = dlsym( handle, "pip_pthread_add_stack_user"   );
-  symp->mallopt       = dlsym( handle, "mallopt"                      );
-  symp->libc_fflush   = dlsym( handle, "fflush"                       );
-  symp->free          = dlsym( handle, "free"                         );
+  PIP_SYMBOL( "__ctype_init",                 ctype_init     ),
+  PIP_SYMBOL( "glibc_init",                   glibc_init     ),
+  PIP_SYMBOL( "pip_pthread_add_stack_user",   add_stack      ),
+  PIP_SYMBOL( "mallopt",                      mallopt        ),
+  PIP_SYMBOL( "fflush",                       libc_fflush    ),
+  PIP_SYMBOL( "free",                         free           ),
   /* variables */
-  symp->environ       = dlsym( handle, "environ"         );
-  symp->libc_argvp    = dlsym( handle, "__libc_argv"     );
-  symp->libc_argcp    = dlsym( handle, "__libc_argc"     );
-  symp->progname      = dlsym( handle, "__progname"      );
-  symp->progname_full = dlsym( handle, "__progname_full" );
+  PIP_SYMBOL( "environ",                      environ        ),
+  PIP_SYMBOL( "__libc_argv",                  libc_argvp     ),
+  PIP_SYMBOL( "__libc_argc",                  libc_argcp     ),
+  PIP_SYMBOL( "__progname",                   progname       ),
+  PIP_SYMBOL( "__progname_full",              progname_full  ),
+};
+
+#define PIP_NSYMBOLS	(sizeof(pip_symbol_table)/sizeof(pip_symbol_table[0]))
+
+#define PIP_SYMBOL_PTR(S,I)	((void**)((char*)(S)+pip_symbol_table[I].offset))
+
+static int pip_check_symbols( pip_symbols_t *symp ) {
+  int err = 0;
 
   /* check mandatory symbols */
   if( symp->main == NULL || symp->environ == NULL ) {
@@ -1050,79 +1776,1237 @@ static int pip_find_symbols( void *handle, pip_symbols_t *symp ) {
   RETURN( err );
 }
 
-static int pip_load_prog( char *prog, pip_task_t *task ) {
-  void		*loaded = NULL;
-  int 		err;
+static int pip_find_symbols( void *handle, pip_symbols_t *symp ) {
+  int i;
 
-  DBGF( "prog=%s", prog );
+  //if( pip_root_p() ) pip_print_dsos();
 
-#ifdef PRINT_MAPS
-  pip_print_maps();
-#endif
-  ES( time_load_dso, ( err = pip_load_dso( &loaded, prog ) ) );
-#ifdef PRINT_MAPS
-  pip_print_maps();
-#endif
-  DBG;
-  if( err == 0 ) {
-    err = pip_find_symbols( loaded, &task->symbols );
-    DBG;
-    if( err != 0 ) {
-      (void) dlclose( loaded );
-    } else {
-      DBG;
-      task->loaded = loaded;
-      pip_load_gdbif( task );
-    }
+  memset( symp, 0, sizeof(pip_symbols_t) );
+  for( i=0; i<PIP_NSYMBOLS; i++ ) {
+    *PIP_SYMBOL_PTR( symp, i ) = dlsym( handle, pip_symbol_table[i].name );
   }
-  RETURN( err );
+  RETURN( pip_check_symbols( symp ) );
 }
 
-#ifdef PIP_DLMOPEN_AND_CLONE
-static int pip_do_corebind( int coreno, cpu_set_t *oldsetp ) {
-  int err = 0;
+/* the program image cache */
 
-  if( coreno != PIP_CPUCORE_ASIS ) {
-    cpu_set_t cpuset;
+static struct link_map *pip_link_map_head( void *handle ) {
+  struct link_map *map;
 
-    CPU_ZERO( &cpuset );
-    CPU_SET( coreno, &cpuset );
+  if( dlinfo( handle, RTLD_DI_LINKMAP, (void*) &map ) != 0 ) return NULL;
+  while( map->l_prev != NULL ) map = map->l_prev;
+  return map;
+}
 
-    if( pip_is_pthread_() ) {
-      err = pthread_getaffinity_np( pthread_self(),
-				    sizeof(cpu_set_t),
-				    oldsetp );
-      if( err == 0 ) {
-	err = pthread_setaffinity_np( pthread_self(),
-				      sizeof(cpu_set_t),
-				      &cpuset );
+static void pip_image_free( pip_image_t *image ) {
+  int i;
+
+  for( i=0; i<PIP_NSYMBOLS; i++ ) free( image->symoffs[i].dso );
+  free( image->realpath );
+  free( image );
+}
+
+/* find the program as dlmopen() does, a name without any slash is */
+/* searched in LD_LIBRARY_PATH and then in the default directories */
+static int pip_image_path( char *prog, char *path ) {
+  char	*dirs[2], *p, *q;
+  int	i, len;
+
+  if( strchr( prog, '/' ) != NULL ) {
+    if( strlen( prog ) >= PATH_MAX ) RETURN( ENAMETOOLONG );
+    strcpy( path, prog );
+    RETURN( 0 );
+  }
+  dirs[0] = getenv( "LD_LIBRARY_PATH" );
+  dirs[1] = "/lib64:/usr/lib64:/lib:/usr/lib";
+  for( i=0; i<2; i++ ) {
+    for( p=dirs[i]; p!=NULL && *p!='\0'; p=q ) {
+      if( ( q = strchr( p, ':' ) ) != NULL ) {
+	len = q ++ - p;
+      } else {
+	len = strlen( p );
       }
-    } else {
-      if( sched_getaffinity( 0, sizeof(cpuset), oldsetp ) != 0 ||
-	  sched_setaffinity( 0, sizeof(cpuset), &cpuset ) != 0 ) {
-	err = errno;
+      if( len == 0 ) continue;
+      if( snprintf( path, PATH_MAX, "%.*s/%s", len, p, prog ) >= PATH_MAX ) {
+	continue;
       }
+      if( access( path, R_OK ) == 0 ) RETURN( 0 );
     }
   }
+  RETURN( ENOENT );
+}
+
+/* an image is keyed by the file, not by the name, so that a rebuilt */
+/* program or a name resolved to another file is never taken as hit */
+static pip_image_t *pip_image_find( struct stat *st ) {
+  pip_image_t *image;
+
+  for( image=pip_root->images; image!=NULL; image=image->next ) {
+    if( image->dev == st->st_dev &&
+	image->ino == st->st_ino &&
+	image->mtime.tv_sec  == st->st_mtim.tv_sec &&
+	image->mtime.tv_nsec == st->st_mtim.tv_nsec ) break;
+  }
+  return image;
+}
+
+static int pip_image_get( char *prog, pip_image_t **imagep ) {
+  pip_image_t	*image, *new;
+  struct stat	st;
+  char		path[PATH_MAX];
+  char		buf[PATH_MAX];
+  int		err;
+
+  if( ( err = pip_image_path( prog, path ) ) != 0 ) RETURN( err );
+  if( stat( path, &st ) != 0 ) RETURN( errno );
+
+  pip_spin_lock( &pip_root->lock_images );
+  image = pip_image_find( &st );
+  pip_spin_unlock( &pip_root->lock_images );
+  if( image != NULL ) goto found;
+
+  /* not found, check the program outside of the lock region */
+  if( ( new = (pip_image_t*) malloc( sizeof(pip_image_t) ) ) == NULL ) {
+    RETURN( ENOMEM );
+  }
+  memset( new, 0, sizeof(pip_image_t) );
+  new->dev     = st.st_dev;
+  new->ino     = st.st_ino;
+  new->mtime   = st.st_mtim;
+  new->err_pie = pip_check_pie( path );
+  pip_shared_section( path, &new->shared_off, &new->shared_size );
+  if( realpath( path, buf ) != NULL ) new->realpath = strdup( buf );
+
+  pip_spin_lock( &pip_root->lock_images );
+  /*** begin lock region ***/
+  if( ( image = pip_image_find( &st ) ) == NULL ) {
+    new->next = pip_root->images;
+    pip_root->images = image = new;
+    new = NULL;
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_images );
+  if( new != NULL ) pip_image_free( new ); /* someone has just added it */
+  (void) __sync_fetch_and_add( &pip_root->stats.image_misses, 1 );
+  *imagep = image;
+  RETURN( 0 );
+
+ found:
+  (void) __sync_fetch_and_add( &pip_root->stats.image_hits, 1 );
+  *imagep = image;
+  RETURN( 0 );
+}
+
+static int pip_image_check( char *prog ) {
+  pip_image_t	*image;
+  int		err;
+
+  if( ( err = pip_image_get( prog, &image ) ) != 0 ) RETURN( err );
+  RETURN( image->err_pie );
+}
+
+/* record where the symbols are found so that the next ones can skip dlsym */
+/* the offsets are built privately and published under the lock since    */
+/* the root, the pip_spawn_async() helpers and the pool loader may record */
+/* the same image at the same time                                        */
+static void pip_image_record( pip_image_t *image,
+			      void *handle,
+			      pip_symbols_t *symp ) {
+  struct link_map	*head, *map, *m;
+  pip_symoff_t		symoffs[PIP_SYMBOLS_MAX], *so;
+  Dl_info		dli;
+  void			*addr;
+  int			i, flag_published = 0;
+
+  if( image->flag_symoffs ) return;
+  if( ( head = pip_link_map_head( handle ) ) == NULL ) return;
+  memset( symoffs, 0, sizeof(symoffs) );
+  for( i=0; i<PIP_NSYMBOLS; i++ ) {
+    so   = &symoffs[i];
+    addr = *PIP_SYMBOL_PTR( symp, i );
+    so->index = -1;
+    if( addr == NULL ) continue;
+    if( !dladdr1( addr, &dli, (void**) &map, RTLD_DL_LINKMAP ) ) goto fail;
+    for( so->index=0, m=head; m!=NULL && m!=map; m=m->l_next ) so->index ++;
+    if( m == NULL ) goto fail;
+    if( ( so->dso = strdup( map->l_name ) ) == NULL ) goto fail;
+    so->offset = (char*) addr - (char*) map->l_addr;
+  }
+  pip_spin_lock( &pip_root->lock_images );
+  /*** begin lock region ***/
+  if( !image->flag_symoffs ) {
+    memcpy( image->symoffs, symoffs, sizeof(symoffs) );
+    pip_memory_barrier();
+    image->flag_symoffs = 1;
+    flag_published = 1;
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_images );
+  if( flag_published ) return;
+
+ fail:
+  for( i=0; i<PIP_NSYMBOLS; i++ ) free( symoffs[i].dso );
+}
+
+/* compute the symbol addresses from the cached offsets */
+static int pip_image_symbols( pip_image_t *image,
+			      void *handle,
+			      pip_symbols_t *symp ) {
+  struct link_map	*head, *map;
+  pip_symoff_t		*so;
+  int			i, j;
+
+  if( !image->flag_symoffs ) RETURN( ENOENT );
+  if( ( head = pip_link_map_head( handle ) ) == NULL ) RETURN( ENXIO );
+  memset( symp, 0, sizeof(pip_symbols_t) );
+  for( i=0; i<PIP_NSYMBOLS; i++ ) {
+    so = &image->symoffs[i];
+    if( so->index < 0 ) continue;
+    for( j=0, map=head; map!=NULL && j<so->index; j++ ) map = map->l_next;
+    /* the same program may be linked with different DSOs, e.g. by */
+    /* LD_LIBRARY_PATH in the environment of the root              */
+    if( map == NULL || strcmp( map->l_name, so->dso ) != 0 ) RETURN( ESTALE );
+    *PIP_SYMBOL_PTR( symp, i ) = (char*) map->l_addr + so->offset;
+  }
+  RETURN( pip_check_symbols( symp ) );
+}
+
+static int pip_get_symbols( pip_image_t *image,
+			    void *handle,
+			    pip_symbols_t *symp ) {
+  int err;
+
+  if( image != NULL && pip_image_symbols( image, handle, symp ) == 0 ) {
+    RETURN( 0 );
+  }
+  if( ( err = pip_find_symbols( handle, symp ) ) == 0 && image != NULL ) {
+    pip_image_record( image, handle, symp );
+  }
   RETURN( err );
 }
 
-static int pip_undo_corebind( int coreno, cpu_set_t *oldsetp ) {
-  int err = 0;
+/* the table of the PIP_SHARED() variables of a loaded program */
+static pip_shared_table_t *pip_shared_table_new( void *handle,
+						 uintptr_t off,
+						 size_t size ) {
+  pip_shared_table_t	*table;
+  pip_shared_var_t	*vars;
+  pip_shared_ent_t	*ent;
+  struct link_map	*map;
+  int			nvars, nslots, i, j;
+
+  nvars = size / sizeof(pip_shared_var_t);
+  if( nvars == 0 ) return NULL;
+  if( dlinfo( handle, RTLD_DI_LINKMAP, (void*) &map ) != 0 ) return NULL;
+  vars = (pip_shared_var_t*) ( map->l_addr + off );
+  for( nslots=2; nslots<nvars*2; nslots*=2 );
+  table = (pip_shared_table_t*)
+    calloc( 1, sizeof(pip_shared_table_t) + sizeof(pip_shared_ent_t) * nslots );
+  if( table == NULL ) return NULL;
+  table->mask = nslots - 1;
+  for( i=0; i<nvars; i++ ) {
+    uint64_t hash = pip_name_hash( vars[i].name );
+    for( j=0; ; j++ ) {
+      ent = &table->ents[ ( hash + j ) & table->mask ];
+      if( ent->var == NULL ) break;
+    }
+    ent->hash = hash;
+    ent->var  = &vars[i];
+    ent->addr = vars[i].addr;
+    if( vars[i].addr == NULL ) table->ntls ++;
+  }
+  DBGF( "%d variables (%d TLS)", nvars, table->ntls );
+  return table;
+}
+
+/* called by the task itself, before calling main() */
+static void pip_shared_resolve_tls( pip_shared_table_t *table ) {
+  pip_shared_ent_t *ent;
+  int i;
+
+  if( table == NULL || table->ntls == 0 ) return;
+  for( i=0; i<=table->mask; i++ ) {
+    ent = &table->ents[i];
+    if( ent->var != NULL && ent->var->tls_addr != NULL ) {
+      ent->addr = ent->var->tls_addr();
+    }
+  }
+  pip_memory_barrier();
+}
+
+static pip_shared_ent_t *pip_shared_find( pip_shared_table_t *table,
+					  const char *name ) {
+  pip_shared_ent_t *ent;
+  uint64_t hash;
+  int i;
+
+  hash = pip_name_hash( name );
+  for( i=0; i<=table->mask; i++ ) {
+    ent = &table->ents[ ( hash + i ) & table->mask ];
+    if( ent->var == NULL ) break;
+    if( ent->hash == hash && strcmp( ent->var->name, name ) == 0 ) return ent;
+  }
+  return NULL;
+}
+
+int pip_get_shared( int pipid, const char *name, void **addrp, size_t *sizep ) {
+  pip_task_t		*task;
+  pip_shared_ent_t	*ent;
+  int			err;
+
+  if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
+  if( name == NULL || addrp == NULL            ) RETURN( EINVAL );
+  task = pip_get_task_( pipid );
+  if( task == NULL || task->loaded == NULL ) RETURN( ESRCH );
+  if( task->shared == NULL ||
+      ( ent = pip_shared_find( task->shared, name ) ) == NULL ) {
+    RETURN( ENOENT );
+  }
+  if( ( *addrp = ent->addr ) == NULL ) RETURN( EAGAIN );
+  if( sizep != NULL ) *sizep = ent->var->size;
+  RETURN( 0 );
+}
+
+static void pip_image_fin( void ) {
+  pip_image_t *image, *next;
+
+  for( image=pip_root->images; image!=NULL; image=next ) {
+    next = image->next;
+    pip_image_free( image );
+  }
+  pip_root->images = NULL;
+}
+
+static int pip_recycle_p( void ) {
+  return pip_root->opts & PIP_OPT_RECYCLE;
+}
+
+/* called for each writable segment in a namespace */
+typedef int(*pip_segment_func_t)(const char*,void*,size_t,void*);
+
+typedef struct {
+  struct link_map	*head;
+  int			flag_text; /* read-only segments as well */
+  pip_segment_func_t	func;
+  void			*arg;
+  int			err;
+} pip_segments_args_t;
+
+/* ld-linux.so is shared with the root namespace, never touch it */
+static int pip_shared_with_root( struct link_map *map ) {
+  struct link_map *root;
+
+  for( root=_r_debug.r_map; root!=NULL; root=root->l_next ) {
+    if( root->l_addr == map->l_addr ) return 1;
+  }
+  return 0;
+}
+
+/* the heap, stdio and environ of libc must be consistent among the */
+/* ULPs sharing a namespace, hence libc is never swapped             */
+static int pip_is_libc( const char *name ) {
+  const char *p = strrchr( name, '/' );
+
+  p = ( p == NULL ) ? name : p + 1;
+  return strncmp( p, "libc.so",     7  ) == 0 ||
+         strncmp( p, "libc-",       5  ) == 0 ||
+         strncmp( p, "libpthread",  10 ) == 0;
+}
+
+static int pip_add_segment( pip_namespace_t *ns,
+			    void *addr,
+			    size_t size,
+			    int shared ) {
+  pip_segment_t	*segs;
+  void		*image;
+
+  if( ( image = malloc( size ) ) == NULL ) RETURN( ENOMEM );
+  segs = (pip_segment_t*)
+    realloc( ns->segs, sizeof(pip_segment_t) * ( ns->nsegs + 1 ) );
+  if( segs == NULL ) {
+    free( image );
+    RETURN( ENOMEM );
+  }
+  memcpy( image, addr, size );
+  segs[ns->nsegs].addr  = addr;
+  segs[ns->nsegs].size  = size;
+  segs[ns->nsegs].image = image;
+  segs[ns->nsegs].shared = shared;
+  ns->segs = segs;
+  ns->nsegs ++;
+  if( !shared ) ns->segs_size += size;
+  RETURN( 0 );
+}
+
+static int
+pip_segments_cb( struct dl_phdr_info *info, size_t size, void *data ) {
+  pip_segments_args_t	*args = (pip_segments_args_t*) data;
+  struct link_map	*map;
+  uintptr_t		start, end, relro = 0;
+  int			i;
+
+  for( map=args->head; map!=NULL; map=map->l_next ) {
+    if( map->l_addr == info->dlpi_addr &&
+	strcmp( map->l_name, info->dlpi_name ) == 0 ) break;
+  }
+  if( map == NULL || pip_shared_with_root( map ) ) return 0;
+
+  for( i=0; i<info->dlpi_phnum; i++ ) {
+    const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+    if( phdr->p_type == PT_GNU_RELRO ) {
+      /* made read-only by ld-linux.so after relocation */
+      relro = info->dlpi_addr + phdr->p_vaddr + phdr->p_memsz;
+      relro &= ~( pip_root->page_size - 1 );
+    }
+  }
+  for( i=0; i<info->dlpi_phnum; i++ ) {
+    const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+    if( phdr->p_type != PT_LOAD ) continue;
+    start = info->dlpi_addr + phdr->p_vaddr;
+    end   = start + phdr->p_memsz;
+    if( !args->flag_text ) {
+      if( !( phdr->p_flags & PF_W ) ) continue;
+      if( relro > start ) start = relro;
+    }
+    if( start >= end ) continue;
+    DBGF( "%s: %p-%p", info->dlpi_name, (void*) start, (void*) end );
+    if( ( args->err = args->func( info->dlpi_name,
+				  (void*) start,
+				  end - start,
+				  args->arg ) ) != 0 ) return 1;
+  }
+  return 0;
+}
+
+/* call func for the writable segments (.data and .bss) of all DSOs */
+/* in the namespace, except the ones shared with the root, or for   */
+/* all loaded segments if flag_text is set                          */
+static int pip_foreach_segment( void *loaded,
+				int flag_text,
+				pip_segment_func_t func,
+				void *arg ) {
+  pip_segments_args_t	args;
+
+  if( ( args.head = pip_link_map_head( loaded ) ) == NULL ) {
+    DBGF( "dlinfo(%p): %s", loaded, dlerror() );
+    RETURN( ENXIO );
+  }
+  args.flag_text = flag_text;
+  args.func = func;
+  args.arg  = arg;
+  args.err  = 0;
+  (void) dl_iterate_phdr( pip_segments_cb, (void*) &args );
+  RETURN( args.err );
+}
+
+static int pip_snapshot_segment( const char *name,
+				 void *addr,
+				 size_t size,
+				 void *arg ) {
+  RETURN( pip_add_segment( (pip_namespace_t*) arg, addr, size,
+			    pip_is_libc( name ) ) );
+}
+
+static int pip_layout_segment( const char *name,
+			       void *addr,
+			       size_t size,
+			       void *arg ) {
+  pip_layout_t	**layoutp = (pip_layout_t**) arg;
+  pip_layout_t	*layout;
+  pip_region_t	*reg;
+  int		n = ( *layoutp == NULL ) ? 0 : (*layoutp)->nregs;
+
+  layout = (pip_layout_t*)
+    realloc( *layoutp, sizeof(pip_layout_t) + sizeof(pip_region_t) * ( n + 1 ) );
+  if( layout == NULL ) RETURN( ENOMEM );
+  reg = &layout->regs[n];
+  reg->start = (uintptr_t) addr;
+  reg->size  = size;
+  reg->hash  = pip_name_hash( name );
+  layout->nregs = n + 1;
+  *layoutp = layout;
+  RETURN( 0 );
+}
+
+/* record where the writable segments of the namespace are, so that */
+/* the same variable of the other tasks is found by the arithmetic  */
+static pip_layout_t *pip_layout_new( void *loaded ) {
+  pip_layout_t *layout = NULL;
+
+  if( pip_foreach_segment( loaded, 0, pip_layout_segment, &layout ) != 0 ) {
+    free( layout );
+    return NULL;
+  }
+  return layout;
+}
+
+int pip_remote_addr( int pipid, const void *addr, void **remotep ) {
+  pip_layout_t	*mine, *theirs;
+  pip_task_t	*task;
+  uintptr_t	a = (uintptr_t) addr;
+  int		i, err;
+
+  if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
+  if( remotep == NULL                          ) RETURN( EINVAL );
+  if( pip_task == NULL || ( mine = pip_task->layout ) == NULL ) RETURN( EPERM );
+  task = pip_get_task_( pipid );
+  if( task == NULL || ( theirs = task->layout ) == NULL ) RETURN( ESRCH );
+  for( i=0; i<mine->nregs; i++ ) {
+    if( a - mine->regs[i].start < mine->regs[i].size ) break;
+  }
+  if( i == mine->nregs ) RETURN( EFAULT );
+  /* both must be the same program linked with the same DSOs */
+  if( i >= theirs->nregs ||
+      theirs->regs[i].hash != mine->regs[i].hash ||
+      theirs->regs[i].size != mine->regs[i].size ) RETURN( ESTALE );
+  *remotep = (void*) ( a - mine->regs[i].start + theirs->regs[i].start );
+  RETURN( 0 );
+}
+
+/* take the pristine images of the writable segments of the namespace, */
+/* right after loading (relocated and constructors are called)         */
+static int pip_ns_snapshot( pip_namespace_t *ns ) {
+  RETURN( pip_foreach_segment( ns->loaded, 0, pip_snapshot_segment, ns ) );
+}
+
+static void pip_ns_restore( pip_namespace_t *ns ) {
+  int i;
+
+  for( i=0; i<ns->nsegs; i++ ) {
+    memcpy( ns->segs[i].addr, ns->segs[i].image, ns->segs[i].size );
+  }
+}
+
+/* copy the writable segments to/from a private image */
+/* (PIP_OPT_ULPSHARE_EXPERIMENTAL)                        */
+static void pip_ns_save( pip_namespace_t *ns, char *image ) {
+  int i;
+
+  for( i=0; i<ns->nsegs; i++ ) {
+    if( ns->segs[i].shared ) continue;
+    memcpy( image, ns->segs[i].addr, ns->segs[i].size );
+    image += ns->segs[i].size;
+  }
+}
+
+static void pip_ns_load( pip_namespace_t *ns, char *image ) {
+  int i;
+
+  for( i=0; i<ns->nsegs; i++ ) {
+    if( ns->segs[i].shared ) continue;
+    memcpy( ns->segs[i].addr, image, ns->segs[i].size );
+    image += ns->segs[i].size;
+  }
+}
+
+static void pip_ns_free( pip_namespace_t *ns ) {
+  int i;
+
+  for( i=0; i<ns->nsegs; i++ ) free( ns->segs[i].image );
+  free( ns->segs );
+  free( ns->prog );
+  free( ns );
+}
+
+static pip_namespace_t *pip_ns_new( char *prog,
+				    void *loaded,
+				    pip_symbols_t *symp,
+				    int flag_snapshot ) {
+  pip_namespace_t *ns;
+
+  if( ( ns = (pip_namespace_t*) malloc( sizeof(*ns) ) ) == NULL ) {
+    return NULL;
+  }
+  memset( ns, 0, sizeof(*ns) );
+  if( ( ns->prog = strdup( prog ) ) == NULL ) {
+    free( ns );
+    return NULL;
+  }
+  ns->loaded  = loaded;
+  ns->symbols = *symp;
+  if( flag_snapshot && pip_ns_snapshot( ns ) != 0 ) {
+    pip_ns_free( ns );
+    return NULL;
+  }
+  return ns;
+}
+
+static void pip_pool_put( pip_namespace_t *ns ) {
+  pip_spin_lock( &pip_root->lock_pool );
+  ns->next = pip_root->pool;
+  pip_root->pool = ns;
+  pip_root->pool_size ++;
+  pip_spin_unlock( &pip_root->lock_pool );
+}
+
+/* the pool has no room for a recycled namespace */
+static int pip_pool_full( void ) {
+  return pip_root->pool_size + pip_root->pool_loading >= pip_root->pool_max;
+}
+
+/* unload the namespaces left in the pool, called by pip_fin() */
+static void pip_pool_fin( void ) {
+  pip_namespace_t *ns, *next;
+
+  for( ns=pip_root->pool; ns!=NULL; ns=next ) {
+    next = ns->next;
+    pip_dlclose( ns->loaded );
+    pip_ns_free( ns );
+  }
+  pip_root->pool      = NULL;
+  pip_root->pool_size = 0;
+}
+
+/* take a pre-loaded namespace of the prog from the pool, if any */
+static pip_namespace_t *pip_pool_take( char *prog ) {
+  pip_namespace_t *ns, **prev;
+
+  pip_spin_lock( &pip_root->lock_pool );
+  /*** begin lock region ***/
+  for( prev=&pip_root->pool; ( ns = *prev ) != NULL; prev=&ns->next ) {
+    if( strcmp( ns->prog, prog ) == 0 ) {
+      *prev = ns->next;
+      pip_root->pool_size --;
+      break;
+    }
+  }
+  if( ns != NULL ) {
+    pip_root->pool_hits ++;
+  } else {
+    pip_root->pool_misses ++;
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_pool );
+  return ns;
+}
+
+#define PIP_MPOL_MAXNODE	(1024)
+#define PIP_MPOL_MASK_WORDS	(PIP_MPOL_MAXNODE/(sizeof(long)*8))
+
+/* PIP_OPT_ULPSHARE_EXPERIMENTAL: the namespaces shared by the ULPs of */
+/* a task. a task is identified by its PIPID and tick_spawn, since the */
+/* slot of a terminated task may be taken by another one               */
+static pip_namespace_t *pip_ns_shared_get( pip_task_t *parent, char *prog ) {
+  pip_namespace_t *ns;
+
+  pip_spin_lock( &pip_root->lock_pool );
+  /*** begin lock region ***/
+  for( ns=pip_root->shared; ns!=NULL; ns=ns->next ) {
+    if( ns->parent_pipid == parent->pipid      &&
+	ns->parent_tick  == parent->tick_spawn &&
+	strcmp( ns->prog, prog ) == 0 ) {
+      ns->nrefs ++;
+      break;
+    }
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_pool );
+  return ns;
+}
+
+static void pip_ns_shared_add( pip_namespace_t *ns, pip_task_t *parent ) {
+  ns->parent_pipid = parent->pipid;
+  ns->parent_tick  = parent->tick_spawn;
+  ns->owner        = NULL;
+  ns->nrefs        = 1;
+  pip_spin_lock( &pip_root->lock_pool );
+  ns->next = pip_root->shared;
+  pip_root->shared = ns;
+  pip_spin_unlock( &pip_root->lock_pool );
+}
+
+/* unloaded when the last ULP sharing it is finalized */
+static void pip_ns_shared_put( pip_namespace_t *ns ) {
+  pip_namespace_t **pp;
+  int nrefs;
+
+  pip_spin_lock( &pip_root->lock_pool );
+  /*** begin lock region ***/
+  if( ( nrefs = -- ns->nrefs ) == 0 ) {
+    for( pp=&pip_root->shared; *pp!=NULL; pp=&(*pp)->next ) {
+      if( *pp == ns ) {
+	*pp = ns->next;
+	break;
+      }
+    }
+  }
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_pool );
+  if( nrefs == 0 ) {
+    DBGF( "unloading shared %s", ns->prog );
+    pip_dlclose( ns->loaded );
+    pip_ns_free( ns );
+  }
+}
+
+/* called by pip_fin() */
+static void pip_ns_shared_fin( void ) {
+  pip_namespace_t *ns, *next;
+
+  for( ns=pip_root->shared; ns!=NULL; ns=next ) {
+    next = ns->next;
+    pip_dlclose( ns->loaded );
+    pip_ns_free( ns );
+  }
+  pip_root->shared = NULL;
+}
+
+static int pip_set_mempolicy( int mode,
+			      unsigned long *nodemask,
+			      unsigned long maxnode ) {
+  if( syscall( SYS_set_mempolicy, mode, nodemask, maxnode ) != 0 ) {
+    RETURN( errno );
+  }
+  RETURN( 0 );
+}
+
+/* the stack of the calling thread (i.e., the task) */
+static int pip_task_stack( void **stackp, size_t *sizep ) {
+  pthread_attr_t attr;
+  int err;
+
+  if( pip_root != NULL &&
+      ( pip_root->opts & PIP_MODE_MASK ) == PIP_MODE_PROCESS_CLONE ) {
+    /* struct pthread made by PiP does not know its stack */
+    uintptr_t sp = (uintptr_t) &attr;
+    int i;
+
+    for( i=0; i<pip_root->ntasks; i++ ) {
+      pip_task_t *task = pip_task_at( i );
+      uintptr_t  stk;
+
+      if( task->type != PIP_TYPE_TASK || task->clone_stack == NULL ) continue;
+      stk = (uintptr_t) task->clone_stack;
+      if( sp >= stk && sp < stk + task->clone_stack_size ) {
+	*stackp = task->clone_stack;
+	*sizep  = task->clone_stack_size;
+	RETURN( 0 );
+      }
+    }
+    RETURN( ESRCH );
+  }
+  if( ( err = pthread_getattr_np( pthread_self(), &attr ) ) != 0 ) {
+    RETURN( err );
+  }
+  err = pthread_attr_getstack( &attr, stackp, sizep );
+  (void) pthread_attr_destroy( &attr );
+  RETURN( err );
+}
+
+/* PIP_OPT_NUMABIND: the pages of a task are moved to its NUMA node */
+static int pip_numa_node( void ) {
+  unsigned int cpu, node;
+
+  if( syscall( SYS_getcpu, &cpu, &node, NULL ) != 0 ) return -1;
+  return node;
+}
+
+static int pip_numa_move( void *addr, size_t size, int node ) {
+  unsigned long	nodemask[PIP_MPOL_MASK_WORDS];
+  size_t	bits  = sizeof(long) * 8;
+  uintptr_t	start = (uintptr_t) addr;
+  uintptr_t	end   = start + size;
+
+  if( node < 0 || node >= PIP_MPOL_MAXNODE ) RETURN( EINVAL );
+  start &= ~( pip_root->page_size - 1 );
+  end    = ( end + pip_root->page_size - 1 ) & ~( pip_root->page_size - 1 );
+  memset( nodemask, 0, sizeof(nodemask) );
+  nodemask[node/bits] = 1UL << ( node % bits );
+  /* the untouched pages will be allocated on the node as well */
+  if( syscall( SYS_mbind,
+	       (void*) start,
+	       end - start,
+	       MPOL_PREFERRED,
+	       nodemask,
+	       PIP_MPOL_MAXNODE,
+	       MPOL_MF_MOVE ) != 0 ) {
+    DBGF( "mbind(%p-%p,%d): %s",
+	  (void*) start, (void*) end, node, strerror( errno ) );
+    RETURN( errno );
+  }
+  RETURN( 0 );
+}
+
+static int pip_numa_move_segment( const char *name,
+				  void *addr,
+				  size_t size,
+				  void *arg ) {
+  /* it is not fatal even if some pages cannot be moved */
+  (void) pip_numa_move( addr, size, *(int*) arg );
+  RETURN( 0 );
+}
+
+static int pip_numabind_p( void ) {
+  return pip_root->opts & PIP_OPT_NUMABIND;
+}
+
+/* an unbound task may run on any node, leave it to the kernel */
+static int pip_task_bound_p( pip_task_t *task ) {
+  return ( task->attr.flags & PIP_SPAWN_ATTR_AFFINITY ) ||
+    task->args.coreno != PIP_CPUCORE_ASIS;
+}
+
+/* move the writable segments of the loaded namespace, called while */
+/* the loading thread is bound as the task will be bound            */
+static void pip_numa_place_prog( pip_task_t *task ) {
+  int node;
+
+  if( ( node = pip_numa_node() ) < 0 ) return;
+  (void) pip_foreach_segment( task->loaded, 0, pip_numa_move_segment, &node );
+  task->numa_node = node;
+}
+
+/* called by the task itself: the stack, and the memory allocated */
+/* afterwards (the malloc arenas) are placed on the NUMA node     */
+static void pip_numa_place_task( pip_task_t *task ) {
+  void		*stack;
+  size_t	size;
+  int		node = task->numa_node;
+
+  if( !pip_task_bound_p( task ) ) return;
+  if( node < 0 && ( node = pip_numa_node() ) < 0 ) return;
+  if( pip_task_stack( &stack, &size ) == 0 ) {
+    (void) pip_numa_move( stack, size, node );
+  }
+  if( !( task->attr.flags & PIP_SPAWN_ATTR_MEMPOLICY ) ) {
+    unsigned long nodemask[PIP_MPOL_MASK_WORDS];
+    size_t	  bits = sizeof(long) * 8;
+
+    memset( nodemask, 0, sizeof(nodemask) );
+    nodemask[node/bits] = 1UL << ( node % bits );
+    (void) pip_set_mempolicy( MPOL_PREFERRED, nodemask, PIP_MPOL_MAXNODE );
+  }
+  task->numa_node = node;
+}
+
+#define PIP_NUMA_REPORT_NODES	(64)
+#define PIP_NUMA_REPORT_BATCH	(256)
+
+static void pip_numa_print( FILE *fp,
+			    const char *name,
+			    void *addr,
+			    size_t size ) {
+  void		*pages[PIP_NUMA_REPORT_BATCH];
+  int		status[PIP_NUMA_REPORT_BATCH];
+  int		counts[PIP_NUMA_REPORT_NODES];
+  int		absent = 0, others = 0;
+  uintptr_t	page  = (uintptr_t) addr & ~( pip_root->page_size - 1 );
+  uintptr_t	end   = (uintptr_t) addr + size;
+  int		n, i;
+
+  memset( counts, 0, sizeof(counts) );
+  while( page < end ) {
+    for( n=0; n<PIP_NUMA_REPORT_BATCH && page<end; n++ ) {
+      pages[n] = (void*) page;
+      page += pip_root->page_size;
+    }
+    /* with NULL nodes, move_pages() only queries where they are */
+    if( syscall( SYS_move_pages, 0, n, pages, NULL, status, 0 ) != 0 ) {
+      for( i=0; i<n; i++ ) status[i] = -ENOENT;
+    }
+    for( i=0; i<n; i++ ) {
+      if( status[i] < 0 ) {
+	absent ++;
+      } else if( status[i] < PIP_NUMA_REPORT_NODES ) {
+	counts[status[i]] ++;
+      } else {
+	others ++;
+      }
+    }
+  }
+  fprintf( fp, "<%d> %s %p:", pip_task->pipid, name, addr );
+  for( i=0; i<PIP_NUMA_REPORT_NODES; i++ ) {
+    if( counts[i] > 0 ) fprintf( fp, " N%d=%d", i, counts[i] );
+  }
+  if( others > 0 ) fprintf( fp, " N?=%d", others );
+  fprintf( fp, " absent=%d\n", absent );
+}
+
+static int pip_numa_print_segment( const char *name,
+				   void *addr,
+				   size_t size,
+				   void *arg ) {
+  if( name == NULL || *name == '\0' ) name = pip_task->args.prog;
+  pip_numa_print( (FILE*) arg, name, addr, size );
+  RETURN( 0 );
+}
+
+int pip_numa_report( FILE *fp ) {
+  void			*stack;
+  size_t		size;
+  int			err;
+
+  if( pip_root == NULL || pip_task == NULL ) RETURN( EPERM  );
+  if( pip_task->loaded == NULL             ) RETURN( EPERM  );
+  if( fp == NULL                           ) RETURN( EINVAL );
+
+  err = pip_foreach_segment( pip_task->loaded, 0, pip_numa_print_segment, fp );
+  if( err != 0 ) RETURN( err );
+  if( pip_task_stack( &stack, &size ) == 0 ) {
+    pip_numa_print( fp, "[stack]", stack, size );
+  }
+  fflush( fp );
+  RETURN( 0 );
+}
+
+/* PIP_OPT_HUGEPAGE: back the segments and stacks with huge pages (THP) */
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE		(25) /* since Linux 6.1 */
+#endif
+
+static int pip_hugepage_p( void ) {
+  return pip_root->opts & PIP_OPT_HUGEPAGE;
+}
+
+static void pip_hugepage_advise( void *addr, size_t size, int flag_collapse ) {
+  uintptr_t	start = (uintptr_t) addr;
+  uintptr_t	end   = start + size;
 
-  if( coreno != PIP_CPUCORE_ASIS ) {
-    if( pip_is_pthread_() ) {
-      err = pthread_setaffinity_np( pthread_self(),
-				    sizeof(cpu_set_t),
-				    oldsetp );
+  start &= ~( pip_root->page_size - 1 );
+  end    = ( end + pip_root->page_size - 1 ) & ~( pip_root->page_size - 1 );
+  if( madvise( (void*) start, end - start, MADV_HUGEPAGE ) != 0 ) {
+    DBGF( "madvise(%p-%p,HUGEPAGE): %s",
+	  (void*) start, (void*) end, strerror( errno ) );
+  }
+  /* the pages already there are collapsed into huge pages right now, */
+  /* the text (file-backed) pages as well if the kernel supports       */
+  if( flag_collapse &&
+      madvise( (void*) start, end - start, MADV_COLLAPSE ) != 0 ) {
+    DBGF( "madvise(%p-%p,COLLAPSE): %s",
+	  (void*) start, (void*) end, strerror( errno ) );
+  }
+}
+
+static int pip_hugepage_segment( const char *name,
+				 void *addr,
+				 size_t size,
+				 void *arg ) {
+  /* it is not fatal even if huge pages are not available */
+  pip_hugepage_advise( addr, size, 1 );
+  RETURN( 0 );
+}
+
+static void pip_hugepage_ns( void *loaded ) {
+  (void) pip_foreach_segment( loaded, 1, pip_hugepage_segment, NULL );
+}
+
+static int pip_load_prog( char *prog, pip_task_t *task ) {
+  pip_namespace_t	*ns;
+  pip_image_t		*image;
+  void			*loaded = NULL;
+  int 			err;
+
+  DBGF( "prog=%s", prog );
+
+  if( ( image = task->args.image ) == NULL &&
+      pip_image_get( prog, &image ) != 0 ) {
+    image = NULL;		/* let dlmopen() find it */
+  } else if( image->err_pie != 0 ) {
+    RETURN( image->err_pie );
+  }
+
+  if( ( ns = pip_pool_take( prog ) ) != NULL ) {
+    DBGF( "pool hit (%s)", prog );
+    task->loaded  = ns->loaded;
+    task->symbols = ns->symbols;
+    if( image != NULL ) {
+      task->shared = pip_shared_table_new( ns->loaded,
+					   image->shared_off,
+					   image->shared_size );
+    }
+    task->layout = pip_layout_new( ns->loaded );
+    if( ns->segs != NULL ) {
+      task->ns = ns;
     } else {
-      if( sched_setaffinity( 0, sizeof(cpu_set_t), oldsetp ) != 0 ) {
-	err = errno;
+      pip_ns_free( ns );
+    }
+    pip_load_gdbif( task, image );
+    RETURN( 0 );
+  }
+
+#ifdef PRINT_MAPS
+  pip_print_maps();
+#endif
+  PIP_PHASE( PIP_SPAWN_PHASE_DLMOPEN,
+	     ( err = pip_load_dso( &loaded, prog ) ) );
+#ifdef PRINT_MAPS
+  pip_print_maps();
+#endif
+  DBG;
+  if( err == 0 ) {
+    PIP_PHASE( PIP_SPAWN_PHASE_SYMBOLS,
+	       ( err = pip_get_symbols( image, loaded, &task->symbols ) ) );
+    DBG;
+    if( err != 0 ) {
+      (void) dlclose( loaded );
+    } else {
+      DBG;
+      task->loaded = loaded;
+      if( image != NULL ) {
+	task->shared = pip_shared_table_new( loaded,
+					     image->shared_off,
+					     image->shared_size );
+      }
+      task->layout = pip_layout_new( loaded );
+      if( pip_hugepage_p() ) pip_hugepage_ns( loaded );
+      if( pip_recycle_p() ) {
+	/* the task runs anyway even if the snapshot fails */
+	task->ns = pip_ns_new( prog, loaded, &task->symbols, 1 );
       }
+      pip_load_gdbif( task, image );
+    }
+  }
+  RETURN( err );
+}
+
+/* reset and put the namespace back to the pool, or leave it, */
+/* returns non-zero if the namespace is put back to the pool    */
+static int pip_unload_prog( pip_task_t *task ) {
+  int recycled = 0;
+
+  if( task->ns_shared != NULL ) {
+    pip_namespace_t *ns = task->ns_shared;
+    if( ns->owner == (void*) task ) ns->owner = NULL;
+    pip_ns_shared_put( ns );
+    free( task->ns_image );
+    task->ns_shared = NULL;
+    task->ns_image  = NULL;
+  } else if( task->ns != NULL && pip_pool_full() ) {
+    DBGF( "pool is full, unloading %s", task->ns->prog );
+    pip_dlclose( task->ns->loaded );
+    pip_ns_free( task->ns );
+  } else if( task->ns != NULL ) {
+    DBGF( "recycling %s", task->ns->prog );
+    pip_ns_restore( task->ns );
+    pip_pool_put( task->ns );
+    recycled = 1;
+  } else if( task->loaded != NULL ) {
+    pip_dlclose( task->loaded );
+  }
+  free( task->shared );
+  free( task->layout );
+  task->shared = NULL;
+  task->layout = NULL;
+  task->ns     = NULL;
+  task->loaded = NULL;
+  return recycled;
+}
+
+typedef struct {
+  char	*prog;
+  int	count;
+} pip_pool_args_t;
+
+static void *pip_pool_loader( void *arg ) {
+  pip_pool_args_t	*args = (pip_pool_args_t*) arg;
+  pip_namespace_t	*ns;
+  pip_image_t		*image = NULL;
+  pip_symbols_t		symbols;
+  void			*loaded;
+  int			err = 0;
+
+  if( pip_image_get( args->prog, &image ) != 0 ) image = NULL;
+  while( args->count > 0 ) {
+    if( pip_root->pool_stop ) break;
+    loaded = NULL;
+    ns     = NULL;
+    pip_spin_lock( &pip_root->lock_ldlinux );
+    /*** begin lock region ***/
+    do {
+      if( ( err = pip_load_dso( &loaded, args->prog ) ) == 0 ) {
+	if( pip_hugepage_p() ) pip_hugepage_ns( loaded );
+	if( ( err = pip_get_symbols( image, loaded, &symbols ) ) == 0 &&
+	    ( ns = pip_ns_new( args->prog, loaded, &symbols,
+				     pip_recycle_p() ) ) == NULL ) {
+	  err = ENOMEM;
+	}
+	if( err != 0 ) (void) pip_dlclose( loaded );
+      }
+    } while( 0 );
+    /*** end lock region ***/
+    pip_spin_unlock( &pip_root->lock_ldlinux );
+    if( err != 0 ) break;
+    pip_pool_put( ns );
+
+    args->count --;
+    /* pip_fin() waits for this, do not touch pip_root after the last one */
+    if( args->count > 0 ) {
+      (void) __sync_fetch_and_sub( &pip_root->pool_loading, 1 );
+    } else {
+      free( args->prog );
+      free( args );
+      (void) __sync_fetch_and_sub( &pip_root->pool_loading, 1 );
+      return NULL;
     }
   }
+  DBGF( "pool loader gives up (%d)", err );
+  {
+    int count = args->count;
+    free( args->prog );
+    free( args );
+    (void) __sync_fetch_and_sub( &pip_root->pool_loading, count );
+  }
+  return NULL;
+}
+
+/* start a pool loader loading up to count namespaces of prog */
+static int pip_pool_start( char *prog, int count ) {
+  pip_pool_args_t	*args;
+  pthread_attr_t	attr;
+  pthread_t		thread;
+  int			n, err;
+
+  pip_spin_lock( &pip_root->lock_pool );
+  n = pip_root->pool_max - pip_root->pool_size - pip_root->pool_loading;
+  if( n > count ) n = count;
+  if( n > 0 ) pip_root->pool_loading += n;
+  pip_spin_unlock( &pip_root->lock_pool );
+  if( n <= 0 ) RETURN( EOVERFLOW );
+
+  if( ( args = (pip_pool_args_t*) malloc( sizeof(*args) ) ) == NULL ) {
+    err = ENOMEM;
+  } else if( ( args->prog = strdup( prog ) ) == NULL ) {
+    free( args );
+    err = ENOMEM;
+  } else {
+    args->count = n;
+    if( ( err = pthread_attr_init( &attr ) ) == 0 ) {
+      (void) pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+      err = pthread_create( &thread, &attr, pip_pool_loader, args );
+      (void) pthread_attr_destroy( &attr );
+    }
+    if( err != 0 ) {
+      free( args->prog );
+      free( args );
+    }
+  }
+  if( err != 0 ) (void) __sync_fetch_and_sub( &pip_root->pool_loading, n );
   RETURN( err );
 }
+
+int pip_pool_prepare( char *prog, int count ) {
+  int err;
+
+  if( pip_root == NULL ) RETURN( EPERM  );
+  if( !pip_root_p_()   ) RETURN( EPERM  );
+  if( prog     == NULL ) RETURN( EINVAL );
+  if( count    <= 0    ) RETURN( EINVAL );
+  if( ( err = pip_image_check( prog ) ) != 0 ) RETURN( err );
+  RETURN( pip_pool_start( prog, count ) );
+}
+
+#ifdef PIP_DLMOPEN_AND_CLONE
+static int pip_pool_has( char *prog ) {
+  pip_namespace_t *ns;
+
+  pip_spin_lock( &pip_root->lock_pool );
+  for( ns=pip_root->pool; ns!=NULL; ns=ns->next ) {
+    if( strcmp( ns->prog, prog ) == 0 ) break;
+  }
+  pip_spin_unlock( &pip_root->lock_pool );
+  return ns != NULL;
+}
+
+/* wait for the pool loader rather than loading the same one by itself */
+static void pip_pool_wait( char *prog ) {
+  while( pip_root->pool_loading > 0 && !pip_pool_has( prog ) ) {
+    sched_yield();
+  }
+}
+#endif
+
+int pip_pool_stats( int *sizep, int *hitsp, int *missesp ) {
+  if( pip_root == NULL ) RETURN( EPERM );
+  if( sizep   != NULL ) *sizep   = pip_root->pool_size;
+  if( hitsp   != NULL ) *hitsp   = pip_root->pool_hits;
+  if( missesp != NULL ) *missesp = pip_root->pool_misses;
+  RETURN( 0 );
+}
+
+#ifdef PIP_DLMOPEN_AND_CLONE
+/* the affinity and memory policy of the root to be restored */
+typedef struct pip_bind_save {
+  int			flag_cpuset;
+  int			flag_mpol;
+  cpu_set_t		cpuset;
+  int			mpol_mode;
+  unsigned long		mpol_nodemask[PIP_MPOL_MASK_WORDS];
+} pip_bind_save_t;
+
+static int pip_set_affinity( size_t size, cpu_set_t *cpuset ) {
+  if( pip_is_pthread_() ) {
+    RETURN( pthread_setaffinity_np( pthread_self(), size, cpuset ) );
+  } else if( sched_setaffinity( 0, size, cpuset ) != 0 ) {
+    RETURN( errno );
+  }
+  RETURN( 0 );
+}
+
+static int pip_get_affinity( size_t size, cpu_set_t *cpuset ) {
+  if( pip_is_pthread_() ) {
+    RETURN( pthread_getaffinity_np( pthread_self(), size, cpuset ) );
+  } else if( sched_getaffinity( 0, size, cpuset ) != 0 ) {
+    RETURN( errno );
+  }
+  RETURN( 0 );
+}
+
+static void pip_undo_bind( pip_bind_save_t *save ) {
+  if( save->flag_mpol ) {
+    (void) pip_set_mempolicy( save->mpol_mode,
+			      save->mpol_nodemask,
+			      PIP_MPOL_MAXNODE );
+  }
+  if( save->flag_cpuset ) {
+    (void) pip_set_affinity( sizeof(cpu_set_t), &save->cpuset );
+  }
+}
+
+/* bind the calling (root) thread as the task will be bound, */
+/* while the program of the task is being loaded             */
+static int pip_do_bind( pip_task_t *task, pip_bind_save_t *save ) {
+  pip_spawn_attr_t *attr = &task->attr;
+  int 		coreno = task->args.coreno;
+  cpu_set_t	cpuset, *setp = NULL;
+  size_t	size = sizeof(cpuset);
+  int 		err = 0;
+
+  save->flag_cpuset = 0;
+  save->flag_mpol   = 0;
+  if( attr->flags & PIP_SPAWN_ATTR_AFFINITY ) {
+    setp = attr->cpuset;
+    size = attr->cpusetsize;
+  } else if( coreno != PIP_CPUCORE_ASIS ) {
+    CPU_ZERO( &cpuset );
+    CPU_SET( coreno, &cpuset );
+    setp = &cpuset;
+  }
+  if( setp != NULL ) {
+    if( ( err = pip_get_affinity( sizeof(cpu_set_t), &save->cpuset ) ) != 0 ||
+	( err = pip_set_affinity( size, setp ) ) != 0 ) RETURN( err );
+    save->flag_cpuset = 1;
+  }
+  if( attr->flags & PIP_SPAWN_ATTR_MEMPOLICY ) {
+    if( syscall( SYS_get_mempolicy,
+		 &save->mpol_mode,
+		 save->mpol_nodemask,
+		 PIP_MPOL_MAXNODE,
+		 NULL,
+		 0 ) != 0 ) {
+      err = errno;
+    } else {
+      err = pip_set_mempolicy( attr->mpol_mode,
+			       attr->mpol_nodemask,
+			       attr->mpol_maxnode );
+    }
+    if( err != 0 ) {
+      pip_undo_bind( save );
+      RETURN( err );
+    }
+    save->flag_mpol = 1;
+  }
+  RETURN( 0 );
+}
 #endif
 
 static int pip_corebind( int coreno ) {
@@ -1145,6 +3029,36 @@ static int pip_corebind( int coreno ) {
   RETURN( 0 );
 }
 
+/* called by the spawned task itself */
+static int pip_task_bind( pip_task_t *task ) {
+  pip_spawn_attr_t *attr = &task->attr;
+  int err;
+
+  if( attr->flags & PIP_SPAWN_ATTR_AFFINITY ) {
+    if( sched_setaffinity( 0, attr->cpusetsize, attr->cpuset ) != 0 ) {
+      RETURN( errno );
+    }
+  } else if( ( err = pip_corebind( task->args.coreno ) ) != 0 ) {
+    RETURN( err );
+  }
+  if( attr->flags & PIP_SPAWN_ATTR_MEMPOLICY ) {
+    err = pip_set_mempolicy( attr->mpol_mode,
+			     attr->mpol_nodemask,
+			     attr->mpol_maxnode );
+    if( err != 0 ) RETURN( err );
+  }
+  if( attr->flags & PIP_SPAWN_ATTR_SCHED ) {
+    struct sched_param param;
+
+    memset( &param, 0, sizeof(param) );
+    param.sched_priority = attr->sched_priority;
+    if( sched_setscheduler( 0, attr->sched_policy, &param ) != 0 ) {
+      RETURN( errno );
+    }
+  }
+  RETURN( 0 );
+}
+
 static int pip_init_glibc( pip_symbols_t *symbols,
 			   char **argv,
 			   char **envv,
@@ -1231,14 +3145,22 @@ static int pip_do_spawn( void *thargs )  {
 #endif
   char **argv = args->argv;
   char **envv = args->envv;
-  int coreno  = args->coreno;
-  pip_task_t *self = &pip_root->tasks[pipid];
+  pip_task_t *self = pip_task_at( pipid );
   pip_spawnhook_t before = self->hook_before;
   void *hook_arg         = self->hook_arg;
   int 	err = 0;
 
   DBG;
-  if( ( err = pip_corebind( coreno ) ) != 0 ) RETURN( err );
+  if( ( err = pip_task_bind( self ) ) != 0 ) RETURN( err );
+  if( pip_numabind_p() ) pip_numa_place_task( self );
+  if( pip_hugepage_p() ) {
+    void   *stack;
+    size_t size;
+    if( pip_task_stack( &stack, &size ) == 0 ) {
+      /* the stack grows page by page, collapsing it makes no sense */
+      pip_hugepage_advise( stack, size, 0 );
+    }
+  }
   DBG;
 
 #ifdef DEBUG
@@ -1260,11 +3182,14 @@ static int pip_do_spawn( void *thargs )  {
   pip_spin_lock( &pip_root->lock_ldlinux );
   /*** begin lock region ***/
   do {
-    ES( time_load_prog, ( err = pip_load_prog( prog, self ) ) );
+    err = pip_load_prog( prog, self );
   } while( 0 );
   /*** end lock region ***/
   pip_spin_unlock( &pip_root->lock_ldlinux );
   if( err != 0 ) RETURN( err );
+  if( pip_numabind_p() && pip_task_bound_p( self ) ) {
+    pip_numa_place_prog( self );
+  }
 #else
   //fprintf( stderr, "self->symbols.add_stack=%p\n", self->symbols.add_stack );
   if( self->symbols.add_stack != NULL ) {
@@ -1272,14 +3197,25 @@ static int pip_do_spawn( void *thargs )  {
   }
 #endif
   DBG;
-  if( !pip_is_shared_fd_() ) pip_close_on_exec();
+  if( !pip_is_shared_fd_() ) {
+    if( ( err = pip_do_file_actions( &self->attr ) ) != 0 ) {
+      pip_warn_mesg( "try to spawn(%s), but a file action fails (%s)",
+		     argv[0], strerror( err ) );
+    } else if( self->attr.flags & PIP_SPAWN_ATTR_CLOEXEC ) {
+      pip_close_on_exec();
+    }
+  }
   DBG;
 
   /* calling hook, if any */
-  if( before != NULL && ( err = before( hook_arg ) ) != 0 ) {
+  if( err == 0 && before != NULL && ( err = before( hook_arg ) ) != 0 ) {
     pip_warn_mesg( "try to spawn(%s), but the before hook at %p returns %d",
 		   argv[0], before, err );
+  }
+  if( err != 0 ) {
     self->retval = err;
+    self->flag_main = PIP_MAIN_FAILED;
+    pip_futex_wake( &self->flag_main );
   } else {
     /* argv and/or envv might be changed in the hook function */
     ucontext_t 		ctx;
@@ -1302,7 +3238,13 @@ static int pip_do_spawn( void *thargs )  {
       }
 
       DBG;
-      argc = pip_init_glibc( &self->symbols, argv, envv, self->loaded, 1 );
+      PIP_PHASE( PIP_SPAWN_PHASE_GLIBC,
+		 ( argc = pip_init_glibc( &self->symbols,
+					  argv, envv, self->loaded, 1 ) ) );
+      pip_shared_resolve_tls( self->shared );
+      pip_stats_add( PIP_SPAWN_PHASE_MAIN, pip_gettick() - self->tick_spawn );
+      self->flag_main = PIP_MAIN_ENTERED;
+      pip_futex_wake( &self->flag_main );
       DBGF( "[%d] >> main@%p(%d,%s,%s,...)",
 	    pipid, self->symbols.main, argc, argv[0], argv[1] );
       self->retval = self->symbols.main( argc, argv, envv );
@@ -1331,132 +3273,408 @@ static int pip_do_spawn( void *thargs )  {
   RETURN( 0 );
 }
 
-static int pip_find_a_free_task( int *pipidp ) {
-  int pipid = *pipidp;
-  int err = 0;
+/* task slot allocation, lock-free on the task_slots bitmap */
 
-  if( pip_root->ntasks_accum >= PIP_NTASKS_MAX ) RETURN( EOVERFLOW );
-  if( pipid < PIP_PIPID_ANY || pipid >= pip_root->ntasks ) {
-    DBGF( "pipid=%d", pipid );
-    RETURN( EINVAL );
-  }
+static int pip_try_task_slot( int pipid ) {
+  uint64_t bit = 1UL << ( pipid % 64 );
 
-  pip_spin_lock( &pip_root->lock_tasks );
-  /*** begin lock region ***/
-  do {
-    if( pipid != PIP_PIPID_ANY ) {
-      if( pip_root->tasks[pipid].pipid != PIP_PIPID_NONE ) {
-	err = EAGAIN;
-	goto unlock;
-      }
-    } else {
-      int i;
+  return !( __sync_fetch_and_or( &pip_root->task_slots[pipid/64], bit ) & bit );
+}
 
-      for( i=pip_root->pipid_curr; i<pip_root->ntasks; i++ ) {
-	if( pip_root->tasks[i].pipid == PIP_PIPID_NONE ) {
-	  pipid = i;
-	  goto found;
-	}
-      }
-      for( i=0; i<pip_root->pipid_curr; i++ ) {
-	if( pip_root->tasks[i].pipid == PIP_PIPID_NONE ) {
-	  pipid = i;
-	  goto found;
-	}
+static void pip_free_task_slot( int pipid ) {
+  uint64_t bit = 1UL << ( pipid % 64 );
+
+  (void) __sync_fetch_and_and( &pip_root->task_slots[pipid/64], ~bit );
+}
+
+/* find a free slot in the range of [from,to) */
+static int pip_find_task_slot( int from, int to ) {
+  volatile uint64_t	*word;
+  uint64_t		occupied, mask;
+  int			w, bit;
+
+  for( w=from/64; w*64<to; w++ ) {
+    mask = ~0UL;
+    if( w == from/64 && from % 64 != 0 ) mask &= ~0UL << ( from % 64 );
+    if( ( w + 1 ) * 64 > to ) mask &= ~0UL >> ( ( w + 1 ) * 64 - to );
+    word = &pip_root->task_slots[w];
+    while( ( ~( occupied = *word ) & mask ) != 0 ) {
+      bit = __builtin_ctzll( ~occupied & mask );
+      if( __sync_bool_compare_and_swap( word,
+					occupied,
+					occupied | ( 1UL << bit ) ) ) {
+	return w * 64 + bit;
       }
-      err = EAGAIN;
-      goto unlock;
     }
-  found:
-    pip_root->tasks[pipid].pipid = pipid;	/* mark it as occupied */
-    pip_root->pipid_curr = pipid + 1;
-    *pipidp = pipid;
+  }
+  return -1;
+}
 
-  } while( 0 );
- unlock:
-  /*** end lock region ***/
-  pip_spin_unlock( &pip_root->lock_tasks );
+/* the gdbif entry of pipid, laid out as the task table */
+static struct pip_gdbif_task *pip_gdbif_task_at( int pipid ) {
+  int idx;
+
+  if( pipid < pip_root->ntasks_init ) return &pip_gdbif_root->tasks[pipid];
+  idx = pipid - pip_root->ntasks_init;
+  return &pip_root->gdbif_segs[idx/PIP_TASK_SEG_SZ][idx%PIP_TASK_SEG_SZ];
+}
 
+/* add segments until pipid becomes valid, the existing ones never move */
+static int pip_grow_tasks( int pipid ) {
+  pip_task_t		*tasks;
+  struct pip_gdbif_task	*gdbif;
+  int			seg, ntasks, i, err = 0;
+
+  if( pipid >= pip_root->ntasks_max ) RETURN( EOVERFLOW );
+  pip_spin_lock( &pip_root->lock_tasks );
+  while( pipid >= ( ntasks = pip_root->ntasks ) ) {
+    seg = ( ntasks - pip_root->ntasks_init ) / PIP_TASK_SEG_SZ;
+    if( ( err = pip_page_alloc( sizeof(pip_task_t) * PIP_TASK_SEG_SZ,
+				(void**) &tasks ) ) != 0 ) break;
+    if( ( gdbif = (struct pip_gdbif_task*)
+	  calloc( PIP_TASK_SEG_SZ, sizeof(struct pip_gdbif_task) ) ) == NULL ) {
+      free( tasks );
+      err = ENOMEM;
+      break;
+    }
+    memset( tasks, 0, sizeof(pip_task_t) * PIP_TASK_SEG_SZ );
+    for( i=0; i<PIP_TASK_SEG_SZ; i++ ) pip_init_task_struct( &tasks[i] );
+    pip_root->task_segs[seg]  = tasks;
+    pip_root->gdbif_segs[seg] = gdbif;
+    pip_memory_barrier();
+    ntasks += PIP_TASK_SEG_SZ;
+    if( ntasks > pip_root->ntasks_max ) ntasks = pip_root->ntasks_max;
+    pip_root->ntasks = ntasks;	/* the new entries are visible now */
+    DBGF( "task table grown to %d", ntasks );
+  }
+  pip_spin_unlock( &pip_root->lock_tasks );
   RETURN( err );
 }
 
-#include <sys/syscall.h>
-static pid_t pip_gettid( void ) {
-  return (pid_t) syscall( (long int) SYS_gettid );
+/* the gdbif entries may still be linked for PiP-gdb, as pip_gdbif_root */
+/* they are left as they are                                           */
+static void pip_free_task_segs( void ) {
+  int i;
+
+  for( i=0; i<PIP_TASK_SEGS_MAX; i++ ) {
+    if( pip_root->task_segs[i] != NULL ) free( pip_root->task_segs[i] );
+  }
 }
 
-int pip_spawn( char *prog,
-	       char **argv,
-	       char **envv,
-	       int  coreno,
-	       int  *pipidp,
-	       pip_spawnhook_t before,
-	       pip_spawnhook_t after,
-	       void *hookarg ) {
-  cpu_set_t 		cpuset;
-  pip_spawn_args_t	*args = NULL;
-  pip_task_t		*task = NULL;
-  struct pip_gdbif_task *gdbif_task = NULL;
-  size_t		stack_size = pip_stack_size();
-  int 			pipid;
-  pid_t			pid = 0;
-  int 			err = 0;
+/* ntasks_accum counts the namespaces consumed by the PiP tasks, one */
+/* is reserved at once so that concurrent spawners never exceed it   */
+static int pip_reserve_ns( void ) {
+  if( __sync_add_and_fetch( &pip_root->ntasks_accum, 1 ) > PIP_NTASKS_MAX ) {
+    (void) __sync_fetch_and_sub( &pip_root->ntasks_accum, 1 );
+    RETURN( EOVERFLOW );
+  }
+  RETURN( 0 );
+}
 
-  DBGF( ">> pip_spawn()" );
+static void pip_release_ns( void ) {
+  (void) __sync_fetch_and_sub( &pip_root->ntasks_accum, 1 );
+}
 
-  if( pip_root == NULL ) RETURN( EPERM );
-  if( pipidp   == NULL ) RETURN( EINVAL );
-  if( argv     == NULL ) RETURN( EINVAL );
-  if( prog     == NULL ) prog = argv[0];
+static int pip_find_a_free_task( int *pipidp ) {
+  int pipid = *pipidp;
+  int curr, ntasks, err;
 
-  pipid = *pipidp;
-  if( ( err = pip_find_a_free_task( &pipid ) ) != 0 ) goto error;
-  task = &pip_root->tasks[pipid];
+  if( pipid < PIP_PIPID_ANY || pipid >= pip_root->ntasks_max ) {
+    DBGF( "pipid=%d", pipid );
+    RETURN( EINVAL );
+  }
+
+  if( pipid != PIP_PIPID_ANY ) {
+    if( pipid >= pip_root->ntasks &&
+	( err = pip_grow_tasks( pipid ) ) != 0 ) RETURN( err );
+    if( !pip_try_task_slot( pipid ) ) RETURN( EAGAIN );
+  } else {
+    /* pipid_curr is just a hint, racy update does not matter */
+    while( 1 ) {
+      ntasks = pip_root->ntasks;
+      curr   = pip_root->pipid_curr;
+      if( curr >= ntasks ) curr = 0;
+      if( ( pipid = pip_find_task_slot( curr, ntasks ) ) >= 0 ||
+	  ( pipid = pip_find_task_slot( 0,    curr   ) ) >= 0 ) break;
+      if( ntasks >= pip_root->ntasks_max ) RETURN( EAGAIN );
+      if( ( err = pip_grow_tasks( ntasks ) ) != 0 ) RETURN( err );
+    }
+    pip_root->pipid_curr = pipid + 1;
+  }
+  pip_task_at( pipid )->pipid = pipid;	/* mark it as occupied */
+  *pipidp = pipid;
+  RETURN( 0 );
+}
+
+static void pip_spawn_undo( pip_task_t *task ) {
+  pip_spawn_args_t *args = &task->args;
+  int pipid = task->pipid;
+
+  DBG;
+  if( args->prog != NULL ) free( args->prog );
+  if( args->argv != NULL ) free( args->argv );
+  pip_free_env( args );
+  pip_spawn_attr_free( &task->attr );
+  (void) pip_unload_prog( task );
+  pip_symcache_clear( task );
+  pip_init_task_struct( task );
+  pip_free_task_slot( pipid );
+  pip_release_ns();
+}
+
+/* what pip_spawn_n() resolves once for all the tasks of a batch */
+typedef struct {
+  pip_image_t		*image;
+  pip_env_block_t	*envblk; /* NULL if each task has its own env */
+} pip_spawn_batch_t;
+
+/* the first half of spawning a PiP task: find a free task slot and */
+/* set up the task structure. nothing is loaded or created yet      */
+static int pip_spawn_setup( char *prog,
+			    char **argv,
+			    char **envv,
+			    int  coreno,
+			    int  *pipidp,
+			    pip_spawnhook_t before,
+			    pip_spawnhook_t after,
+			    void *hookarg,
+			    pip_spawn_attr_t *attr,
+			    pip_spawn_batch_t *batch,
+			    pip_task_t **taskp ) {
+  pip_spawn_args_t	*args;
+  pip_task_t		*task;
+  struct pip_gdbif_task *gdbif_task;
+  uint64_t		tick = pip_gettick();
+  int 			pipid = *pipidp;
+  int 			err;
+
+  if( ( err = pip_reserve_ns() ) != 0 ) RETURN( err );
+  PIP_PHASE( PIP_SPAWN_PHASE_SLOT, ( err = pip_find_a_free_task( &pipid ) ) );
+  if( err != 0 ) {
+    pip_release_ns();
+    RETURN( err );
+  }
+  task = pip_task_at( pipid );
   pip_init_task_struct( task );
   task->pipid = pipid;	/* mark it as occupied */
   task->type  = PIP_TYPE_TASK;
+  task->tick_spawn = tick;
+  task->numa_node  = -1;
 
   if( envv == NULL ) envv = environ;
   args = &task->args;
   args->pipid       = pipid;
   args->coreno      = coreno;
-  if( ( args->prog = strdup( prog )              ) == NULL ||
-      ( args->argv = pip_copy_vec( argv )        ) == NULL ||
-      ( args->envv = pip_copy_env( envv, pipid ) ) == NULL ) {
-    err = ENOMEM;
-    goto error;
+  tick = pip_gettick();
+  if( batch != NULL ) args->image = batch->image;
+  if( ( args->prog = strdup( prog )       ) == NULL ||
+      ( args->argv = pip_copy_vec( argv ) ) == NULL ||
+      ( args->envv = ( batch != NULL && batch->envblk != NULL ) ?
+	pip_copy_env_block( batch->envblk, pipid, &args->envblk ) :
+	pip_copy_env( envv, pipid, &args->envblk ) ) == NULL ) {
+    pip_spawn_undo( task );
+    RETURN( ENOMEM );
+  }
+  pip_stats_add( PIP_SPAWN_PHASE_COPY, pip_gettick() - tick );
+  if( attr != NULL &&
+      ( err = pip_spawn_attr_copy( &task->attr, attr ) ) != 0 ) {
+    pip_spawn_undo( task );
+    RETURN( err );
   }
   task->hook_before = before;
   task->hook_after  = after;
   task->hook_arg    = hookarg;
   pip_spin_init( &task->lock_malloc );
 
-  gdbif_task = &pip_gdbif_root->tasks[pipid];
+  gdbif_task = pip_gdbif_task_at( pipid );
   task->pid = -1; /* pip_init_gdbif_task_struct() refers this */
   pip_init_gdbif_task_struct( gdbif_task, task );
   pip_link_gdbif_task_struct( gdbif_task );
   task->gdbif_task = gdbif_task;
 
+  *pipidp = pipid;
+  *taskp  = task;
+  RETURN( 0 );
+}
+
+static int pip_spawn_load( pip_task_t *task ) {
+  int err = 0;
 #ifdef PIP_DLMOPEN_AND_CLONE
+  pip_bind_save_t save;
+
   pip_spin_lock( &pip_root->lock_ldlinux );
   /*** begin lock region ***/
   do {
-    if( ( err = pip_do_corebind( coreno, &cpuset ) ) == 0 ) {
+    PIP_PHASE( PIP_SPAWN_PHASE_COREBIND,
+	       ( err = pip_do_bind( task, &save ) ) );
+    if( err == 0 ) {
       /* corebinding should take place before loading solibs,       */
       /* hoping anon maps would be mapped onto the closer numa node */
 
-      ES( time_load_prog, ( err = pip_load_prog( prog, task ) ) );
+      err = pip_load_prog( task->args.prog, task );
+      if( err == 0 && save.flag_cpuset && pip_numabind_p() ) {
+	/* make sure they are, instead of just hoping */
+	pip_numa_place_prog( task );
+      }
+
+      /* and of course, the corebinding must be undone */
+      pip_undo_bind( &save );
+    }
+  } while( 0 );
+  /*** end lock region ***/
+  pip_spin_unlock( &pip_root->lock_ldlinux );
+#endif
+  RETURN( err );
+}
+
+/* find a free request slot of the preloaded clone() wrapper */
+static pip_clone_req_t *pip_clone_request( pip_clone_t *info, pid_t tid ) {
+  int i, contended = 0;
+
+  (void) __sync_fetch_and_add( &info->count_reqs, 1 );
+  while( 1 ) {
+    for( i=0; i<PIP_CLONE_NREQS; i++ ) {
+      if( info->reqs[i].tid == 0 &&
+	  __sync_bool_compare_and_swap( &info->reqs[i].tid, 0, tid ) ) {
+	info->reqs[i].pid_clone = 0;
+	(void) __sync_fetch_and_add( &info->nreqs, 1 );
+	return &info->reqs[i];
+      }
+    }
+    if( !contended ) {
+      contended = 1;
+      (void) __sync_fetch_and_add( &info->count_contended, 1 );
+    }
+    pip_pause();
+  }
+}
+
+static void pip_clone_release( pip_clone_t *info, pip_clone_req_t *req ) {
+  (void) __sync_fetch_and_sub( &info->nreqs, 1 );
+  req->pid_clone = 0;
+  pip_memory_barrier();
+  req->tid = 0;
+}
+
+#ifdef __x86_64__
+/* the head of struct pthread (tcbhead_t) on x86_64 */
+typedef struct {
+  void			*tcb;
+  void			*dtv;
+  void			*self;
+  int			multiple_threads;
+  int			gscope_flag;
+  uintptr_t		sysinfo;
+  uintptr_t		stack_guard;
+  uintptr_t		pointer_guard;
+} pip_tcbhead_t;
+#endif
+
+static int pip_clone_direct_start( void *args ) {
+  pip_spawn_args_t *spawn_args = (pip_spawn_args_t*) args;
+
+  (void) pip_do_spawn( args );
+  /* exit() here would call the atexit handlers of the root */
+  (void) syscall( SYS_exit_group,
+		  pip_task_at( spawn_args->pipid )->retval & 0xFF );
+  return 0;			/* not reached */
+}
+
+static void pip_clone_direct_free( pip_task_t *task ) {
+  if( task->clone_tls != NULL ) {
+    pip_dl_deallocate_tls_ptr( task->clone_tls, 1 );
+    task->clone_tls = NULL;
+  }
+  if( task->clone_stack != NULL ) {
+    size_t pgsz = pip_root->page_size;
+    (void) munmap( task->clone_stack - pgsz, task->clone_stack_size + pgsz );
+    task->clone_stack = NULL;
+  }
+}
+
+/* process:clone, calling clone() with the TLS block allocated by ld.so */
+static int pip_clone_direct( pip_task_t *task, size_t stack_size, pid_t *pidp ) {
+#ifdef __x86_64__
+  pip_tcbhead_t	*tcb, *cur;
+  void		*dtv, *region;
+  size_t	pgsz = pip_root->page_size;
+  int		flags;
+
+  stack_size = ( stack_size + pgsz - 1 ) & ~( pgsz - 1 );
+  region = mmap( NULL,
+		 stack_size + pgsz,
+		 PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+		 -1,
+		 0 );
+  if( region == MAP_FAILED ) RETURN( errno );
+  /* guard page at the bottom */
+  if( mprotect( region, pgsz, PROT_NONE ) != 0 ) {
+    int err = errno;
+    (void) munmap( region, stack_size + pgsz );
+    RETURN( err );
+  }
+  task->clone_stack      = region + pgsz;
+  task->clone_stack_size = stack_size;
 
-      /* and of course, the corebinding must be undone */
-      (void) pip_undo_corebind( coreno, &cpuset );
-    }
-  } while( 0 );
-  /*** end lock region ***/
+  /* the static TLS blocks (incl. the ones of the namespaces) */
+  /* are initialized from their images, as pthread_create() does */
+  pip_spin_lock( &pip_root->lock_ldlinux );
+  tcb = (pip_tcbhead_t*) pip_dl_allocate_tls_ptr( NULL );
   pip_spin_unlock( &pip_root->lock_ldlinux );
-
-  if( err != 0 ) goto error;
+  if( tcb == NULL ) {
+    pip_clone_direct_free( task );
+    RETURN( ENOMEM );
+  }
+  task->clone_tls = tcb;
+  /* the stack and pointer guards must be the same with the root */
+  /* since they are shared by the mangled pointers in libc       */
+  cur = (pip_tcbhead_t*) pthread_self();
+  dtv = tcb->dtv;
+  memcpy( tcb, cur, sizeof(pip_tcbhead_t) );
+  tcb->tcb  = tcb;
+  tcb->self = tcb;
+  tcb->dtv  = dtv;
+  tcb->multiple_threads = 1;
+
+  flags =
+    CLONE_VM |
+    /* CLONE_FS | CLONE_FILES | */
+    /* CLONE_SIGHAND | CLONE_THREAD | */
+    CLONE_SETTLS |
+    CLONE_PARENT_SETTID |
+    CLONE_CHILD_SETTID |
+    CLONE_SYSVSEM |
+    CLONE_PTRACE |
+    SIGCHLD;
+  /* so that gettid() (i.e., THREAD_GETMEM(tid)) works in the task */
+  if( clone( pip_clone_direct_start,
+	     task->clone_stack + stack_size,
+	     flags,
+	     &task->args,
+	     pidp,
+	     tcb,
+	     (void*) tcb + pip_thread_db_tid[2] ) < 0 ) {
+    int err = errno;
+    pip_clone_direct_free( task );
+    RETURN( err );
+  }
+  task->thread = (pthread_t) tcb;
+  RETURN( 0 );
+#else
+  RETURN( ENOSYS );
 #endif
+}
+
+/* the second half: create the thread (or process) running the task */
+static int pip_spawn_clone( pip_task_t *task, size_t stack_size ) {
+  pip_spawn_args_t	*args = &task->args;
+  pid_t			pid   = 0;
+  int 			err   = 0;
 
+  if( task->attr.flags & PIP_SPAWN_ATTR_STACKSIZE ) {
+    stack_size = task->attr.stacksize;
+  }
   if( ( pip_root->opts & PIP_MODE_PROCESS_PIPCLONE ) ==
       PIP_MODE_PROCESS_PIPCLONE ) {
     int flags =
@@ -1470,20 +3688,29 @@ int pip_spawn( char *prog,
       CLONE_PTRACE |
       SIGCHLD;
 
-    err = pip_clone_mostly_pthread_ptr( &task->thread,
-					flags,
-					coreno,
-					stack_size,
-					(void*(*)(void*)) pip_do_spawn,
-					args,
-					&pid );
+    PIP_PHASE( PIP_SPAWN_PHASE_CLONE,
+	       ( err = pip_clone_mostly_pthread_ptr( &task->thread,
+						     flags,
+						     args->coreno,
+						     stack_size,
+						     (void*(*)(void*)) pip_do_spawn,
+						     args,
+						     &pid ) ) );
     DBGF( "pip_clone_mostly_pthread_ptr()=%d", err );
+  } else if( ( pip_root->opts & PIP_MODE_MASK ) == PIP_MODE_PROCESS_CLONE ) {
+    task->clone_tls   = NULL;
+    task->clone_stack = NULL;
+    PIP_PHASE( PIP_SPAWN_PHASE_CLONE,
+	       ( err = pip_clone_direct( task, stack_size, &pid ) ) );
+    DBGF( "pip_clone_direct()=%d", err );
   } else {
     pthread_attr_t 	attr;
     pid_t tid = pip_gettid();
 
     if( ( err = pthread_attr_init( &attr ) ) == 0 ) {
 #ifdef PIP_CLONE_AND_DLMOPEN
+      cpu_set_t cpuset;
+      int coreno = args->coreno;
       if( coreno != PIP_CPUCORE_ASIS &&
 	  coreno >= 0                &&
 	  coreno <  sizeof(cpuset) * 8 ) {
@@ -1499,56 +3726,428 @@ int pip_spawn( char *prog,
 	DBGF( "pthread_attr_setstacksize( %ld )= %d", stack_size, err );
       }
 #endif
+      if( err == 0 && ( task->attr.flags & PIP_SPAWN_ATTR_STACKSIZE ) ) {
+	err = pthread_attr_setstacksize( &attr, stack_size );
+	DBGF( "pthread_attr_setstacksize( %ld )= %d", stack_size, err );
+      }
     }
     if( err == 0 ) {
+      pip_clone_req_t *req = NULL;
+
       DBGF( "tid=%d  cloneinfo@%p", tid, pip_root->cloneinfo );
       if( pip_root->cloneinfo != NULL ) {
-	/* lock is needed, because the preloaded clone()
-	   might also be called from outside of PiP lib. */
-	pip_spin_lock_wv( &pip_root->cloneinfo->lock, tid );
+	/* tell the preloaded clone() that the clone() called by */
+	/* this thread is for PiP, the others are left untouched  */
+	req = pip_clone_request( pip_root->cloneinfo, tid );
       }
       DBG;
       do {
-	err = pthread_create( &task->thread,
-			      &attr,
-			      (void*(*)(void*)) pip_do_spawn,
-			      (void*) args );
+	PIP_PHASE( PIP_SPAWN_PHASE_CLONE,
+		   ( err = pthread_create( &task->thread,
+					   &attr,
+					   (void*(*)(void*)) pip_do_spawn,
+					   (void*) args ) ) );
 	DBGF( "pthread_create()=%d", errno );
       } while( 0 );
-      /* unlock is done in the wrapper function */
       DBG;
-      if( pip_root->cloneinfo != NULL ) {
-	pid = pip_root->cloneinfo->pid_clone;
-	pip_root->cloneinfo->pid_clone = 0;
+      if( req != NULL ) {
+	pid = req->pid_clone;
+	pip_clone_release( pip_root->cloneinfo, req );
       }
     }
   }
   DBG;
   if( err == 0 ) {
     task->pid = pid;
-    pip_root->ntasks_accum ++;
-    pip_root->ntasks_curr  ++;
-    gdbif_task->pid = pid;
-    gdbif_task->status = PIP_GDBIF_STATUS_CREATED;
-    *pipidp = pipid;
+    (void) __sync_fetch_and_add( &pip_root->ntasks_curr,  1 );
+    task->gdbif_task->pid = pid;
+    task->gdbif_task->status = PIP_GDBIF_STATUS_CREATED;
+  }
+  RETURN( err );
+}
+
+int pip_spawn_attr_init( pip_spawn_attr_t *attr ) {
+  if( attr == NULL ) RETURN( EINVAL );
+  memset( attr, 0, sizeof(pip_spawn_attr_t) );
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_destroy( pip_spawn_attr_t *attr ) {
+  if( attr == NULL ) RETURN( EINVAL );
+  pip_spawn_attr_free( attr );
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_setflags( pip_spawn_attr_t *attr, int flags ) {
+  if( attr == NULL                        ) RETURN( EINVAL );
+  if( flags & ~PIP_SPAWN_ATTR_CLOEXEC     ) RETURN( EINVAL );
+  attr->flags = ( attr->flags & ~PIP_SPAWN_ATTR_CLOEXEC ) | flags;
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_setaffinity( pip_spawn_attr_t *attr,
+				size_t cpusetsize,
+				const cpu_set_t *cpuset ) {
+  cpu_set_t *set;
+
+  if( attr == NULL || cpuset == NULL || cpusetsize == 0 ) RETURN( EINVAL );
+  if( CPU_COUNT_S( cpusetsize, cpuset ) == 0 ) RETURN( EINVAL );
+  if( ( set = pip_dup_mem( (void*) cpuset, cpusetsize ) ) == NULL ) {
+    RETURN( ENOMEM );
+  }
+  free( attr->cpuset );
+  attr->cpuset     = set;
+  attr->cpusetsize = cpusetsize;
+  attr->flags     |= PIP_SPAWN_ATTR_AFFINITY;
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_setstacksize( pip_spawn_attr_t *attr, size_t stacksize ) {
+  if( attr == NULL                  ) RETURN( EINVAL );
+  if( stacksize < PTHREAD_STACK_MIN ) RETURN( EINVAL );
+  attr->stacksize = stacksize;
+  attr->flags    |= PIP_SPAWN_ATTR_STACKSIZE;
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_setschedpolicy( pip_spawn_attr_t *attr,
+				   int policy,
+				   int priority ) {
+  int min, max;
+
+  if( attr == NULL ) RETURN( EINVAL );
+  if( ( min = sched_get_priority_min( policy ) ) < 0 ||
+      ( max = sched_get_priority_max( policy ) ) < 0 ) RETURN( EINVAL );
+  if( priority < min || priority > max ) RETURN( EINVAL );
+  attr->sched_policy   = policy;
+  attr->sched_priority = priority;
+  attr->flags         |= PIP_SPAWN_ATTR_SCHED;
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_setmempolicy( pip_spawn_attr_t *attr,
+				 int mode,
+				 const unsigned long *nodemask,
+				 unsigned long maxnode ) {
+  unsigned long *mask = NULL;
+
+  if( attr == NULL ) RETURN( EINVAL );
+  if( nodemask == NULL ) {
+    maxnode = 0;
+  } else if( maxnode == 0 ) {
+    RETURN( EINVAL );
+  } else if( ( mask = pip_dup_mem( (void*) nodemask,
+				   pip_nodemask_size( maxnode ) ) ) == NULL ) {
+    RETURN( ENOMEM );
+  }
+  free( attr->mpol_nodemask );
+  attr->mpol_mode     = mode;
+  attr->mpol_nodemask = mask;
+  attr->mpol_maxnode  = maxnode;
+  attr->flags        |= PIP_SPAWN_ATTR_MEMPOLICY;
+  RETURN( 0 );
+}
+
+static int pip_spawn_attr_add( pip_spawn_attr_t *attr,
+			       int type,
+			       int fd,
+			       int newfd ) {
+  pip_file_action_t *actions;
+
+  if( attr == NULL        ) RETURN( EINVAL );
+  if( fd < 0 || newfd < 0 ) RETURN( EBADF  );
+  actions = (pip_file_action_t*)
+    realloc( attr->actions, sizeof(pip_file_action_t) * ( attr->nactions + 1 ) );
+  if( actions == NULL ) RETURN( ENOMEM );
+  actions[attr->nactions].type  = type;
+  actions[attr->nactions].fd    = fd;
+  actions[attr->nactions].newfd = newfd;
+  attr->actions = actions;
+  attr->nactions ++;
+  RETURN( 0 );
+}
+
+int pip_spawn_attr_addclose( pip_spawn_attr_t *attr, int fd ) {
+  RETURN( pip_spawn_attr_add( attr, PIP_FILE_ACTION_CLOSE, fd, 0 ) );
+}
+
+int pip_spawn_attr_adddup2( pip_spawn_attr_t *attr, int fd, int newfd ) {
+  RETURN( pip_spawn_attr_add( attr, PIP_FILE_ACTION_DUP2, fd, newfd ) );
+}
+
+int pip_spawn_attr_addclosefrom( pip_spawn_attr_t *attr, int lowfd ) {
+  RETURN( pip_spawn_attr_add( attr, PIP_FILE_ACTION_CLOSEFROM, lowfd, 0 ) );
+}
+
+int pip_spawn( char *prog,
+	       char **argv,
+	       char **envv,
+	       int  coreno,
+	       int  *pipidp,
+	       pip_spawnhook_t before,
+	       pip_spawnhook_t after,
+	       void *hookarg ) {
+  RETURN( pip_spawn_ex( prog, argv, envv, coreno, pipidp,
+			before, after, hookarg, NULL ) );
+}
+
+int pip_spawn_ex( char *prog,
+		  char **argv,
+		  char **envv,
+		  int  coreno,
+		  int  *pipidp,
+		  pip_spawnhook_t before,
+		  pip_spawnhook_t after,
+		  void *hookarg,
+		  pip_spawn_attr_t *attr ) {
+  pip_task_t		*task = NULL;
+  size_t		stack_size;
+  int 			pipid;
+  int 			err = 0;
+
+  DBGF( ">> pip_spawn()" );
+
+  if( pip_root == NULL ) RETURN( EPERM );
+  if( pipidp   == NULL ) RETURN( EINVAL );
+  if( argv     == NULL ) RETURN( EINVAL );
+  if( prog     == NULL ) prog = argv[0];
+
+  stack_size = pip_stack_size();
+  pipid = *pipidp;
+  err = pip_spawn_setup( prog, argv, envv, coreno, &pipid,
+			 before, after, hookarg, attr, NULL, &task );
+  if( err == 0 ) {
+    if( ( err = pip_spawn_load(  task             ) ) == 0 &&
+	( err = pip_spawn_clone( task, stack_size ) ) == 0 ) {
+      *pipidp = pipid;
+    } else {
+      pip_spawn_undo( task );
+    }
+  }
+  DBGF( "<< pip_spawn(pipid=%d)", *pipidp );
+  RETURN( err );
+}
+
+int pip_spawn_n( char *prog,
+		 char ***argvs,
+		 char ***envvs,
+		 int  *corenos,
+		 int  pipid,
+		 int  ntasks,
+		 int  *pipids,
+		 int  *errs ) {
+  pip_spawn_batch_t	batch;
+  pip_task_t		*task;
+  size_t		stack_size;
+  char			**envv;
+  int			coreno, id, nahead = 0;
+  int			i, err, rv = 0;
+
+  DBGF( ">> pip_spawn_n(%d)", ntasks );
+
+  if( pip_root == NULL ) RETURN( EPERM );
+  if( argvs    == NULL ) RETURN( EINVAL );
+  if( ntasks   <= 0    ) RETURN( EINVAL );
+  if( pipid != PIP_PIPID_ANY &&
+      ( pipid < 0 || pipid + ntasks > pip_root->ntasks_max ) ) RETURN( EINVAL );
+  for( i=0; i<ntasks; i++ ) {
+    if( argvs[i] == NULL ) RETURN( EINVAL );
+  }
+  if( prog == NULL ) prog = argvs[0][0];
+
+  /* the program and the environment are resolved once for all */
+  memset( &batch, 0, sizeof(batch) );
+  if( pip_image_get( prog, &batch.image ) != 0 ) batch.image = NULL;
+  if( envvs == NULL ) batch.envblk = pip_env_block_get( environ );
+
+#ifdef PIP_DLMOPEN_AND_CLONE
+  /* the namespaces of the following tasks are loaded by the pool */
+  /* loader while the preceding tasks are being created           */
+  if( ntasks > 1 &&
+      ( batch.image == NULL || batch.image->err_pie == 0 ) &&
+      pip_pool_start( prog, ntasks - 1 ) == 0 ) nahead = ntasks - 1;
+#endif
+
+  stack_size = pip_stack_size();
+  for( i=0; i<ntasks; i++ ) {
+    id     = ( pipid == PIP_PIPID_ANY ) ? PIP_PIPID_ANY : pipid + i;
+    envv   = ( envvs   == NULL ) ? NULL             : envvs[i];
+    coreno = ( corenos == NULL ) ? PIP_CPUCORE_ASIS : corenos[i];
+    err = pip_spawn_setup( prog, argvs[i], envv, coreno, &id,
+			   NULL, NULL, NULL, NULL, &batch, &task );
+    if( err == 0 ) {
+#ifdef PIP_DLMOPEN_AND_CLONE
+      if( i > 0 && nahead > 0 ) pip_pool_wait( prog );
+#endif
+      if( ( err = pip_spawn_load(  task             ) ) != 0 ||
+	  ( err = pip_spawn_clone( task, stack_size ) ) != 0 ) {
+	pip_spawn_undo( task );
+      }
+    }
+    if( pipids != NULL ) pipids[i] = ( err == 0 ) ? id : PIP_PIPID_NONE;
+    if( errs   != NULL ) errs[i]   = err;
+    if( err != 0 && rv == 0 ) rv = err;
+  }
+  if( batch.envblk != NULL ) pip_env_block_put( batch.envblk );
+  DBGF( "<< pip_spawn_n()=%d", rv );
+  RETURN( rv );
+}
+
+static void *pip_spawn_async_helper( void *arg ) {
+  pip_spawn_handle_t handle = (pip_spawn_handle_t) arg;
+  pip_task_t *task = handle->task;
+  int err;
+
+  if( ( err = pip_spawn_load(  task                     ) ) != 0 ||
+      ( err = pip_spawn_clone( task, handle->stack_size ) ) != 0 ) {
+    pip_spawn_undo( task );
+  }
+  handle->err = err;
+  return NULL;
+}
+
+int pip_spawn_async( char *prog,
+		     char **argv,
+		     char **envv,
+		     int  coreno,
+		     int  *pipidp,
+		     pip_spawnhook_t before,
+		     pip_spawnhook_t after,
+		     void *hookarg,
+		     pip_spawn_handle_t *handlep ) {
+  pip_spawn_handle_t	handle;
+  pip_task_t		*task = NULL;
+  int 			pipid;
+  int 			err;
+
+  DBGF( ">> pip_spawn_async()" );
+
+  if( pip_root == NULL ) RETURN( EPERM );
+  if( pipidp   == NULL ) RETURN( EINVAL );
+  if( argv     == NULL ) RETURN( EINVAL );
+  if( handlep  == NULL ) RETURN( EINVAL );
+  if( prog     == NULL ) prog = argv[0];
 
+  if( ( handle = (pip_spawn_handle_t) malloc( sizeof(*handle) ) ) == NULL ) {
+    RETURN( ENOMEM );
+  }
+  handle->stack_size = pip_stack_size();
+  handle->err        = 0;
+  handle->joined     = 0;
+
+  pipid = *pipidp;
+  err = pip_spawn_setup( prog, argv, envv, coreno, &pipid,
+			 before, after, hookarg, NULL, NULL, &task );
+  if( err == 0 ) {
+    handle->task  = task;
+    handle->pipid = pipid;
+    handle->tick  = task->tick_spawn;
+    err = pthread_create( &handle->thread, NULL,
+			  pip_spawn_async_helper, (void*) handle );
+    if( err != 0 ) pip_spawn_undo( task );
+  }
+  if( err == 0 ) {
+    *pipidp  = pipid;
+    *handlep = handle;
   } else {
-  error:			/* undo */
-    DBG;
-    if( args != NULL ) {
-      if( args->prog != NULL ) free( args->prog );
-      if( args->argv != NULL ) free( args->argv );
-      if( args->envv != NULL ) free( args->envv );
+    free( handle );
+  }
+  DBGF( "<< pip_spawn_async(pipid=%d)", pipid );
+  RETURN( err );
+}
+
+static int pip_spawn_complete( pip_spawn_handle_t handle, int flag_try ) {
+  pip_task_t	*task;
+  uint32_t	flag;
+  int		err;
+
+  if( handle == NULL ) RETURN( EINVAL );
+  if( !handle->joined ) {
+    if( flag_try ) {
+      if( pthread_tryjoin_np( handle->thread, NULL ) != 0 ) RETURN( EAGAIN );
+    } else {
+      (void) pthread_join( handle->thread, NULL );
     }
-    if( task != NULL ) {
-      if( task->loaded != NULL ) (void) pip_dlclose( task->loaded );
-      pip_init_task_struct( task );
+    handle->joined = 1;
+  }
+  /* the helper thread has finished loading and creating the task */
+  task = handle->task;
+  if( ( err = handle->err ) == 0 ) {
+    /* if pip_wait() has been called, the slot may be someone else's */
+    while( task->pipid      == handle->pipid &&
+	   task->tick_spawn == handle->tick  &&
+	   ( flag = task->flag_main ) == PIP_MAIN_NOTYET ) {
+      if( flag_try ) RETURN( EAGAIN );
+      pip_futex_wait( &task->flag_main, PIP_MAIN_NOTYET );
     }
+    if( task->pipid      == handle->pipid &&
+	task->tick_spawn == handle->tick  &&
+	flag == PIP_MAIN_FAILED ) err = ECANCELED;
   }
-  DBGF( "<< pip_spawn(pipid=%d)", *pipidp );
+  free( handle );
   RETURN( err );
 }
 
+int pip_spawn_test( pip_spawn_handle_t handle ) {
+  RETURN( pip_spawn_complete( handle, 1 ) );
+}
+
+int pip_spawn_wait( pip_spawn_handle_t handle ) {
+  RETURN( pip_spawn_complete( handle, 0 ) );
+}
+
+int pip_get_spawn_stats( pip_spawn_stats_t *stats ) {
+  struct timespec	ts;
+  uint64_t		ticks;
+  double		ns;
+
+  if( pip_root == NULL ) RETURN( EPERM  );
+  if( !pip_root_p_()   ) RETURN( EPERM  );
+  if( stats    == NULL ) RETURN( EINVAL );
+
+  ticks = pip_gettick() - pip_root->stats_tick0;
+  (void) clock_gettime( CLOCK_MONOTONIC, &ts );
+  ns = (double) ( ts.tv_sec  - pip_root->stats_ts0.tv_sec  ) * 1.0e9 +
+       (double) ( ts.tv_nsec - pip_root->stats_ts0.tv_nsec );
+  memcpy( stats, &pip_root->stats, sizeof(pip_spawn_stats_t) );
+  stats->ns_per_tick = ( ticks > 0 ) ? ns / (double) ticks : 0.0;
+  RETURN( 0 );
+}
+
+static void pip_print_spawn_stats( FILE *fp ) {
+  static char *names[PIP_SPAWN_NPHASES] = {
+    "slot", "copy", "corebind", "dlmopen",
+    "symbols", "clone", "glibc", "main"
+  };
+  pip_spawn_stats_t	stats;
+  pip_phase_stats_t	*ps;
+  double		f;
+  int			i, j;
+
+  if( pip_get_spawn_stats( &stats ) != 0 ) return;
+  f = stats.ns_per_tick;
+  fprintf( fp, "PiP spawn stats (%.3f ns/tick)\n", f );
+  fprintf( fp, "%-10s %8s %12s %12s %12s  [ns]\n",
+	   "phase", "count", "avg", "min", "max" );
+  for( i=0; i<PIP_SPAWN_NPHASES; i++ ) {
+    ps = &stats.phase[i];
+    if( ps->count == 0 ) continue;
+    fprintf( fp, "%-10s %8lu %12.0f %12.0f %12.0f\n",
+	     names[i], (unsigned long) ps->count,
+	     f * (double) ps->sum / (double) ps->count,
+	     f * (double) ps->min,
+	     f * (double) ps->max );
+    for( j=0; j<PIP_SPAWN_STATS_NBINS; j++ ) {
+      if( ps->hist[j] == 0 ) continue;
+      fprintf( fp, "%10s < %12.0f : %lu\n", "",
+	       f * (double) ( 2UL << j ), (unsigned long) ps->hist[j] );
+    }
+  }
+  fprintf( fp, "image cache: %lu hits, %lu misses\n",
+	   (unsigned long) stats.image_hits,
+	   (unsigned long) stats.image_misses );
+}
+
 int pip_fin( void ) {
   int ntasks, i, err = 0;
 
@@ -1557,23 +4156,33 @@ int pip_fin( void ) {
   if( pip_root_p_() ) {
     ntasks = pip_root->ntasks;
     for( i=0; i<ntasks; i++ ) {
-      if( pip_root->tasks[i].pipid != PIP_PIPID_NONE ) {
-	DBGF( "%d/%d [%d] -- BUSY", i, ntasks, pip_root->tasks[i].pipid );
+      if( pip_task_at( i )->pipid != PIP_PIPID_NONE ) {
+	DBGF( "%d/%d [%d] -- BUSY", i, ntasks, pip_task_at( i )->pipid );
 	err = EBUSY;
 	break;
       }
     }
     if( err == 0 ) {
+      char *env = getenv( PIP_ENV_SPAWN_STATS );
+      if( env != NULL && *env != '\0' ) pip_print_spawn_stats( stderr );
+      /* stop the namespace pool loader(s), if any, they finish */
+      /* loading the current one at most                        */
+      pip_root->pool_stop = 1;
+      while( pip_root->pool_loading > 0 ) pip_pause();
+      pip_pool_fin();
+      pip_ns_shared_fin();
+      pip_image_fin();
+      pip_env_block_fin();
+      free( pip_root->task_root->shared );
+      pip_free_task_segs();
+      free( pip_root->named );
+
       memset( pip_root, 0, pip_root->size );
       DBG;
       free( pip_root );
       pip_root = NULL;
       pip_task = NULL;
       pip_ulp  = NULL;
-
-      REPORT( time_load_dso   );
-      REPORT( time_load_prog );
-      REPORT( time_dlmopen   );
     }
   } else if( pip_ulp == NULL ) {
     pip_root = NULL;
@@ -1686,6 +4295,7 @@ static void pip_finalize_gdbif_tasks( void ) {
 static void pip_finalize_task( pip_task_t *task, int *retvalp ) {
 
   struct pip_gdbif_task *gdbif_task = task->gdbif_task;
+  int pipid;
 
   DBGF( "pipid=%d", task->pipid );
 
@@ -1704,19 +4314,33 @@ static void pip_finalize_task( pip_task_t *task, int *retvalp ) {
   pip_finalize_gdbif_tasks();
   pip_spin_unlock( &pip_gdbif_root->lock_free );
 
+  pip_named_export_fin( task->pipid );
+  pip_symcache_clear( task );
   if( retvalp != NULL ) *retvalp = ( task->retval & 0xFF );
   DBGF( "retval=%d", task->retval );
 
+  if( task->type == PIP_TYPE_TASK ) {
+    (void) __sync_fetch_and_sub( &pip_root->ntasks_curr, 1 );
+  }
   /* dlclose() and free() must be called only from the root process since */
   /* corresponding dlmopen() and malloc() is called by the root process   */
-  if( task->loaded     != NULL ) pip_dlclose( task->loaded );
+  if( task->type == PIP_TYPE_TASK &&
+      ( pip_root->opts & PIP_MODE_MASK ) == PIP_MODE_PROCESS_CLONE ) {
+    pip_clone_direct_free( task );
+  }
+  /* a recycled namespace does not count */
+  if( pip_unload_prog( task ) && task->type == PIP_TYPE_TASK ) {
+    pip_release_ns();
+  }
   if( task->args.prog  != NULL ) free( task->args.prog );
   if( task->args.argv  != NULL ) free( task->args.argv );
-  if( task->args.envv  != NULL ) free( task->args.envv );
+  pip_free_env( &task->args );
+  pip_spawn_attr_free( &task->attr );
   /* and the after hook may free the hook_arg if it is malloc()ed */
   if( task->hook_after != NULL ) (void) task->hook_after( task->hook_arg );
-
+  pipid = task->pipid;
   pip_init_task_struct( task );
+  pip_free_task_slot( pipid );
 }
 
 static int pip_do_wait( int pipid, int flag_try, int *retvalp ) {
@@ -1725,7 +4349,7 @@ static int pip_do_wait( int pipid, int flag_try, int *retvalp ) {
 
   if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
   if( pipid      == PIP_PIPID_ROOT ) RETURN( EINVAL );
-  task = &pip_root->tasks[pipid];
+  task = pip_task_at( pipid );
   if( task       == pip_task       ) RETURN( EPERM ); /* unable to wait itself */
   if( task->type == PIP_TYPE_ULP   ) RETURN( EPERM ); /* unable to wait ULP    */
 
@@ -1775,6 +4399,20 @@ int pip_trywait( int pipid, int *retvalp ) {
   RETURN( pip_do_wait( pipid, 1, retvalp ) );
 }
 
+int pip_clone_stats( uint64_t *reqsp, uint64_t *contendedp ) {
+  pip_clone_t *info;
+
+  if( pip_root == NULL ) RETURN( EPERM );
+  info = pip_root->cloneinfo;
+  if( reqsp      != NULL ) *reqsp      = 0;
+  if( contendedp != NULL ) *contendedp = 0;
+  if( info != NULL ) {
+    if( reqsp      != NULL ) *reqsp      = info->count_reqs;
+    if( contendedp != NULL ) *contendedp = info->count_contended;
+  }
+  RETURN( 0 );
+}
+
 pip_clone_t *pip_get_cloneinfo_( void ) {
   return pip_root->cloneinfo;
 }
@@ -1789,7 +4427,7 @@ int pip_get_pid_( int pipid, pid_t *pidp ) {
       if( pipid == PIP_PIPID_ROOT ) {
 	err = EPERM;
       } else {
-	*pidp = pip_root->tasks[pipid].pid;
+	*pidp = pip_task_at( pipid )->pid;
       }
     }
   } else {
@@ -1802,10 +4440,244 @@ void pip_barrier_init( pip_barrier_t *barrp, int n ) {
   barrp->count       = n;
   barrp->count_init  = n;
   barrp->gsense      = 0;
+  barrp->type        = PIP_BARRIER_CENTRAL;
+  barrp->ex          = NULL;
+}
+
+/* number of the CPUs in a list, such as "0-7,16-23", in a sysfs file */
+static int pip_cpulist_count( const char *path ) {
+  FILE	*fp;
+  char	buf[1024], *p, *q;
+  long	from, to;
+  int	count = 0;
+
+  if( ( fp = fopen( path, "r" ) ) == NULL ) return 0;
+  if( fgets( buf, sizeof(buf), fp ) != NULL ) {
+    for( p=buf; *p!='\0' && *p!='\n'; ) {
+      from = to = strtol( p, &q, 10 );
+      if( q == p ) break;
+      if( *q == '-' ) {
+	p  = q + 1;
+	to = strtol( p, &q, 10 );
+	if( q == p ) break;
+      }
+      count += to - from + 1;
+      p = ( *q == ',' ) ? q + 1 : q;
+    }
+  }
+  (void) fclose( fp );
+  return count;
+}
+
+/* fan-ins of the combining tree: cores sharing a L3 cache, the L3 */
+/* caches in a socket, then PIP_BARRIER_TREE_FANIN. the sysfs lists */
+/* count the SMT threads, hence divided by the threads per core     */
+static void pip_barrier_tree( pip_barrier_ex_t *ex, int n ) {
+  int smt, l3, pkg, k, span;
+
+  smt = pip_cpulist_count(
+	  "/sys/devices/system/cpu/cpu0/topology/thread_siblings_list" );
+  l3  = pip_cpulist_count(
+	  "/sys/devices/system/cpu/cpu0/cache/index3/shared_cpu_list" );
+  pkg = pip_cpulist_count(
+	  "/sys/devices/system/cpu/cpu0/topology/core_siblings_list" );
+  if( smt > 1 ) {
+    l3  /= smt;
+    pkg /= smt;
+  }
+  if( l3  < 2 ) l3 = PIP_BARRIER_TREE_FANIN;
+  if( pkg < l3 ) pkg = l3;
+  for( k=0, span=1; span<n && k<PIP_BARRIER_LEVELS_MAX; k++ ) {
+    switch( k ) {
+    case 0:  ex->fanin[k] = l3;        break;
+    case 1:  ex->fanin[k] = pkg / l3;  break;
+    default: ex->fanin[k] = PIP_BARRIER_TREE_FANIN;
+    }
+    if( ex->fanin[k] < 2 ) ex->fanin[k] = 2;
+    span *= ex->fanin[k];
+    ex->span[k] = span;
+  }
+  ex->nlevels = k;
+  DBGF( "n=%d levels=%d fanin[0]=%d fanin[1]=%d",
+	n, ex->nlevels, ex->fanin[0], ex->fanin[1] );
+}
+
+int pip_barrier_init_ex( pip_barrier_t *barrp, int n, int type ) {
+  pip_barrier_ex_t	*ex;
+  int			nrounds, nslots, err;
+
+  if( barrp == NULL || n < 1 ) RETURN( EINVAL );
+  switch( type ) {
+  case PIP_BARRIER_CENTRAL:
+    pip_barrier_init( barrp, n );
+    RETURN( 0 );
+  case PIP_BARRIER_DISSEMINATION:
+  case PIP_BARRIER_TOURNAMENT:
+  case PIP_BARRIER_TREE:
+    break;
+  default:
+    RETURN( EINVAL );
+  }
+  for( nrounds=0; ( 1 << nrounds ) < n; nrounds++ );
+  /* the combining tree has no more levels than the rounds */
+  nslots = nrounds + 3;
+  if( ( err = pip_page_alloc( sizeof(pip_barrier_ex_t) +
+			      sizeof(pip_barrier_flag_t) * nslots * n,
+			      (void**) &ex ) ) != 0 ) {
+    RETURN( err );
+  }
+  memset( ex, 0, sizeof(pip_barrier_ex_t) +
+	  sizeof(pip_barrier_flag_t) * nslots * n );
+  ex->n       = n;
+  ex->nrounds = nrounds;
+  ex->nslots  = nslots;
+  if( type == PIP_BARRIER_TREE ) pip_barrier_tree( ex, n );
+  pip_barrier_init( barrp, n );
+  barrp->type = type;
+  barrp->ex   = ex;
+  RETURN( 0 );
+}
+
+void pip_barrier_fin( pip_barrier_t *barrp ) {
+  if( barrp != NULL ) {
+    free( barrp->ex );
+    barrp->ex   = NULL;
+    barrp->type = PIP_BARRIER_CENTRAL;
+  }
+}
+
+/* the flags are compared so that they can wrap around */
+static void pip_barrier_spin( volatile uint32_t *flag, uint32_t val ) {
+  while( (int32_t) ( *flag - val ) < 0 ) pip_pause();
+  pip_memory_barrier();
+}
+
+static void pip_barrier_set( volatile uint32_t *flag, uint32_t val ) {
+  pip_memory_barrier();
+  *flag = val;
+}
+
+/* in round k, signal the (r+2^k)-th and wait for the (r-2^k)-th */
+static void pip_barrier_dissemination( pip_barrier_ex_t *ex,
+				       int r,
+				       uint32_t val ) {
+  int k;
+
+  for( k=0; k<ex->nrounds; k++ ) {
+    pip_barrier_set( PIP_BARRIER_FLAG( ex, ( r + ( 1 << k ) ) % ex->n, k ),
+		     val );
+    pip_barrier_spin( PIP_BARRIER_FLAG( ex, r, k ), val );
+  }
+}
+
+/* the winners of round k are multiples of 2^(k+1), each loser waits */
+/* to be released by the one it lost to, then releases its losers    */
+static void pip_barrier_tournament( pip_barrier_ex_t *ex,
+				    int r,
+				    uint32_t val ) {
+  int k, bit;
+
+  for( k=0; k<ex->nrounds; k++ ) {
+    bit = 1 << k;
+    if( r & bit ) {
+      pip_barrier_set( PIP_BARRIER_FLAG( ex, r - bit, k ), val );
+      pip_barrier_spin( PIP_BARRIER_FLAG( ex, r, PIP_BARRIER_RELEASE(ex) ),
+			val );
+      break;
+    }
+    if( r + bit < ex->n ) pip_barrier_spin( PIP_BARRIER_FLAG( ex, r, k ), val );
+  }
+  for( k--; k>=0; k-- ) {
+    bit = 1 << k;
+    if( r + bit < ex->n ) {
+      pip_barrier_set( PIP_BARRIER_FLAG( ex, r + bit, PIP_BARRIER_RELEASE(ex) ),
+		       val );
+    }
+  }
+}
+
+/* the same with the tournament, but the fan-in of level k is fanin[k] */
+/* and the members count up the flag of their leader                   */
+static void pip_barrier_combining( pip_barrier_ex_t *ex,
+				   int r,
+				   uint32_t val ) {
+  int k, j, stride, nmembers;
+
+  for( k=0; k<ex->nlevels; k++ ) {
+    stride = ( k == 0 ) ? 1 : ex->span[k-1];
+    if( r % ex->span[k] != 0 ) {
+      pip_memory_barrier();
+      (void) __sync_fetch_and_add( PIP_BARRIER_FLAG( ex, r - r % ex->span[k], k ),
+				   1 );
+      pip_barrier_spin( PIP_BARRIER_FLAG( ex, r, PIP_BARRIER_RELEASE(ex) ),
+			val );
+      break;
+    }
+    for( j=1, nmembers=0; j<ex->fanin[k] && r+j*stride<ex->n; j++ ) {
+      nmembers ++;
+    }
+    /* the flag counts all the arrivals so far */
+    if( nmembers > 0 ) {
+      pip_barrier_spin( PIP_BARRIER_FLAG( ex, r, k ), val * nmembers );
+    }
+  }
+  for( k--; k>=0; k-- ) {
+    stride = ( k == 0 ) ? 1 : ex->span[k-1];
+    for( j=1; j<ex->fanin[k] && r+j*stride<ex->n; j++ ) {
+      pip_barrier_set( PIP_BARRIER_FLAG( ex, r + j * stride,
+					 PIP_BARRIER_RELEASE(ex) ),
+		       val );
+    }
+  }
+}
+
+static void pip_barrier_wait_ex( pip_barrier_t *barrp ) {
+  pip_barrier_ex_t	*ex = barrp->ex;
+  volatile uint32_t	*episode;
+  uint32_t		val;
+  uint32_t		id, owner;
+  int			pipid, r;
+
+  pipid = pip_get_pipid_();
+  r = ( pipid == PIP_PIPID_ROOT ) ? ex->n - 1 : pipid;
+  if( r < 0 || r >= ex->n ) {
+    pip_err_mesg( "pip_barrier_wait(): PIPID %d is out of range (%d)",
+		  pipid, ex->n );
+    return;
+  }
+  /* the root and the PiP task of PIPID n-1 would share the rank */
+  id = pipid - PIP_PIPID_ROOT + 1;
+  owner = *PIP_BARRIER_FLAG( ex, r, PIP_BARRIER_OWNER(ex) );
+  if( owner != id &&
+      ( owner != 0 ||
+	!__sync_bool_compare_and_swap( PIP_BARRIER_FLAG( ex, r,
+							 PIP_BARRIER_OWNER(ex) ),
+				       0, id ) ) ) {
+    pip_err_mesg( "pip_barrier_wait(): the PiP root and PIPID %d "
+		  "cannot join the same barrier of %d participants",
+		  ex->n - 1, ex->n );
+    return;
+  }
+  /* only the participant itself touches its episode counter */
+  episode = PIP_BARRIER_FLAG( ex, r, PIP_BARRIER_EPISODE(ex) );
+  val = ++(*episode);
+  switch( barrp->type ) {
+  case PIP_BARRIER_DISSEMINATION:
+    pip_barrier_dissemination( ex, r, val );
+    break;
+  case PIP_BARRIER_TOURNAMENT:
+    pip_barrier_tournament( ex, r, val );
+    break;
+  case PIP_BARRIER_TREE:
+    pip_barrier_combining( ex, r, val );
+    break;
+  }
 }
 
 void pip_barrier_wait( pip_barrier_t *barrp ) {
-  if( barrp->count_init > 1 ) {
+  if( barrp->count_init > 1 && barrp->ex != NULL ) {
+    pip_barrier_wait_ex( barrp );
+  } else if( barrp->count_init > 1 ) {
     int lsense = !barrp->gsense;
     if( __sync_sub_and_fetch( &barrp->count, 1 ) == 0 ) {
       barrp->count  = barrp->count_init;
@@ -1851,7 +4723,7 @@ void pip_free( void *ptr ) {
     if( pipid == PIP_PIPID_ROOT ) {
       task = pip_root->task_root;
     } else {
-      task = &pip_root->tasks[pipid];
+      task = pip_task_at( pipid );
     }
     /* need of sanity check on pipid */
     if( ( free_func = task->symbols.free ) != NULL ) {
@@ -1872,45 +4744,67 @@ void pip_free( void *ptr ) {
 /* ULP ULP ULP ULP ULP ULP ULP ULP ULP ULP ULP ULP ULP */
 /*-----------------------------------------------------*/
 
-static void pip_ulp_recycle_stack( void *stack ) {
-  /* the first page is protected as stack guard */
+/* a free ULP stack, kept at the lowest address of the stack itself */
+typedef struct pip_ulp_stack {
+  struct pip_ulp_stack	*next;
+  size_t		size;
+} pip_ulp_stack_t;
+
+static void pip_ulp_recycle_stack( void *stack, size_t size ) {
+  pip_ulp_stack_t *stk = (pip_ulp_stack_t*) stack;
+
+  if( stack == NULL ) return;
+  /* give the touched pages back, so that an idle stack costs no RSS */
+  (void) madvise( stack, size, MADV_DONTNEED );
   pip_spin_lock( &pip_root->lock_stack_flist );
   {
-    *((void**)stack) = pip_root->stack_flist;
-    pip_root->stack_flist = stack;
+    stk->next = pip_root->stack_flist;
+    stk->size = size;
+    pip_root->stack_flist = stk;
   }
   pip_spin_unlock( &pip_root->lock_stack_flist );
 }
 
-static void *pip_ulp_reuse_stack( pip_task_t *task ) {
-  void *stack;
+static void *pip_ulp_reuse_stack( size_t size ) {
+  pip_ulp_stack_t *stk, **prev;
+
   pip_spin_lock( &pip_root->lock_stack_flist );
   {
-    stack = pip_root->stack_flist;
-    if( pip_root->stack_flist != NULL ) {
-      pip_root->stack_flist = *((void**)stack);
+    prev = (pip_ulp_stack_t**) &pip_root->stack_flist;
+    for( ; ( stk = *prev ) != NULL; prev = &stk->next ) {
+      if( stk->size == size ) {
+	*prev = stk->next;
+	break;
+      }
     }
   }
   pip_spin_unlock( &pip_root->lock_stack_flist );
-  return stack;
+  return stk;
 }
 
-static void *pip_ulp_alloc_stack( void ) {
+static void *pip_ulp_alloc_stack( size_t stksz ) {
   void 		*stack;
 
-  if( ( stack = pip_ulp_reuse_stack( pip_task ) ) == NULL ) {
+  if( ( stack = pip_ulp_reuse_stack( stksz ) ) == NULL ) {
     /* guard pages, top and bottom, to be idependent from stack direction */
     size_t	pgsz  = pip_root->page_size;
-    size_t	stksz = pip_stack_size();
     size_t	sz    = stksz + pgsz + pgsz;
     void       *region;
 
-    if( pip_page_alloc( sz, &region ) != 0 ) return NULL;
+    /* only the touched pages are committed */
+    region = mmap( NULL,
+		   sz,
+		   PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+		   -1,
+		   0 );
+    if( region == MAP_FAILED ) return NULL;
     if( mprotect( region,            pgsz, PROT_NONE ) != 0 ||
 	mprotect( region+pgsz+stksz, pgsz, PROT_NONE ) != 0 ) {
-      pip_ulp_recycle_stack( region+pgsz );
+      (void) munmap( region, sz );
       return NULL;
     }
+    if( pip_hugepage_p() ) pip_hugepage_advise( region+pgsz, stksz, 0 );
     return region + pgsz;
   } else {
     return stack;
@@ -1919,6 +4813,79 @@ static void *pip_ulp_alloc_stack( void ) {
 
 #define MASK32		(0xFFFFFFFF)
 
+/* PIP_OPT_ULPSHARE_EXPERIMENTAL: the ULPs of the same program created */
+/* by the same task run in one namespace, since they never run at the  */
+/* same time                                                           */
+static int pip_ulp_share( char *prog, pip_task_t *ulpt ) {
+  pip_task_t		*parent;
+  pip_namespace_t	*ns;
+  int			err = 0;
+
+  parent = ( pip_task != NULL ) ? pip_task : pip_root->task_root;
+
+  if( ( ns = pip_ns_shared_get( parent, prog ) ) == NULL ) {
+    pip_spin_lock( &pip_root->lock_ldlinux );
+    /*** begin lock region ***/
+    do {
+      if( ( err = pip_load_prog( prog, ulpt ) ) != 0 ) break;
+      if( ulpt->ns != NULL ) {	/* recycled one, snapshot is there */
+	ns = ulpt->ns;
+	ulpt->ns = NULL;
+      } else if( ( ns = pip_ns_new( prog, ulpt->loaded,
+				    &ulpt->symbols, 1 ) ) == NULL ) {
+	err = ENOMEM;
+	break;
+      }
+    } while( 0 );
+    /*** end lock region ***/
+    pip_spin_unlock( &pip_root->lock_ldlinux );
+    if( err != 0 ) RETURN( err );
+    pip_ns_shared_add( ns, parent );
+  } else {
+    pip_image_t *image;
+
+    ulpt->loaded  = ns->loaded;
+    ulpt->symbols = ns->symbols;
+    if( pip_image_get( prog, &image ) != 0 ) image = NULL;
+    if( image != NULL ) {
+      ulpt->shared = pip_shared_table_new( ns->loaded,
+					   image->shared_off,
+					   image->shared_size );
+    }
+    pip_load_gdbif( ulpt, image );
+  }
+  /* a new ULP starts with the pristine segments */
+  if( ( ulpt->ns_image = malloc( ns->segs_size ) ) == NULL ) {
+    pip_ns_shared_put( ns );
+    ulpt->loaded = NULL;
+    RETURN( ENOMEM );
+  }
+  {
+    char *image = (char*) ulpt->ns_image;
+    int i;
+    for( i=0; i<ns->nsegs; i++ ) {
+      if( ns->segs[i].shared ) continue;
+      memcpy( image, ns->segs[i].image, ns->segs[i].size );
+      image += ns->segs[i].size;
+    }
+  }
+  ulpt->ns_shared = ns;
+  RETURN( 0 );
+}
+
+/* swap in the segments of the ULP if it shares the namespace */
+static void pip_ulp_switch_ns( pip_task_t *ulpt ) {
+  pip_namespace_t	*ns = ulpt->ns_shared;
+  pip_task_t		*owner;
+
+  if( ns == NULL || ns->owner == (void*) ulpt ) return;
+  if( ( owner = (pip_task_t*) ns->owner ) != NULL ) {
+    pip_ns_save( ns, owner->ns_image );
+  }
+  pip_ns_load( ns, ulpt->ns_image );
+  ns->owner = (void*) ulpt;
+}
+
 int pip_ulp_create( char *prog,
 		    char **argv,
 		    char **envv,
@@ -1926,42 +4893,70 @@ int pip_ulp_create( char *prog,
 		    pip_ulp_termcb_t termcb,
 		    void *aux,
 		    pip_ulp_t *ulp ) {
+  RETURN( pip_ulp_create_ex( prog, argv, envv, pipidp,
+			     termcb, aux, ulp, NULL ) );
+}
+
+int pip_ulp_create_ex( char *prog,
+		       char **argv,
+		       char **envv,
+		       int  *pipidp,
+		       pip_ulp_termcb_t termcb,
+		       void *aux,
+		       pip_ulp_t *ulp,
+		       pip_spawn_attr_t *attr ) {
   pip_spawn_args_t	*args = NULL;
   pip_task_t		*ulpt = NULL;
+  size_t		stack_size;
   int			pipid;
   int 			err = 0;
 
   if( pip_root == NULL && pip_task == NULL ) RETURN( EPERM );
   if( argv     == NULL ) RETURN( EINVAL );
   if( ulp      == NULL ) RETURN( EINVAL );
+  if( attr != NULL && ( attr->flags & PIP_SPAWN_ATTR_STACKSIZE ) ) {
+    stack_size  = attr->stacksize;
+    stack_size += pip_root->page_size - 1;
+    stack_size &= ~( pip_root->page_size - 1 );
+  } else {
+    stack_size = pip_stack_size();
+  }
   if( prog == NULL ) prog = argv[0];
   if( envv == NULL ) envv = environ;
 
   DBGF( ">> pip_ulp_create()" );
 
+  /* ULPs are only checked against ntasks_accum, not counted */
+  if( pip_root->ntasks_accum >= PIP_NTASKS_MAX ) RETURN( EOVERFLOW );
   pipid = *pipidp;
   if( ( err = pip_find_a_free_task( &pipid ) ) != 0 ) goto error;
 
-  ulpt = &pip_root->tasks[pipid];
+  ulpt = pip_task_at( pipid );
   pip_init_task_struct( ulpt );
-  ulpt->type = PIP_TYPE_ULP;
+  ulpt->pipid = pipid;	/* mark it as occupied */
+  ulpt->type  = PIP_TYPE_ULP;
+  ulpt->tick_spawn = pip_gettick();
 
   args = &ulpt->args;
   args->pipid = pipid;
-  if( ( args->prog = strdup( prog )              ) == NULL ||
-      ( args->argv = pip_copy_vec( argv )        ) == NULL ||
-      ( args->envv = pip_copy_env( envv, pipid ) ) == NULL ) {
+  if( ( args->prog = strdup( prog )                             ) == NULL ||
+      ( args->argv = pip_copy_vec( argv )                       ) == NULL ||
+      ( args->envv = pip_copy_env( envv, pipid, &args->envblk ) ) == NULL ) {
     err = ENOMEM;
     goto error;
   }
 
-  pip_spin_lock( &pip_root->lock_ldlinux );
-  /*** begin lock region ***/
-  do {
-    ES( time_load_prog, ( err = pip_load_prog( prog, ulpt ) ) );
-  } while( 0 );
-  /*** end lock region ***/
-  pip_spin_unlock( &pip_root->lock_ldlinux );
+  if( pip_root->opts & PIP_OPT_ULPSHARE_EXPERIMENTAL ) {
+    err = pip_ulp_share( prog, ulpt );
+  } else {
+    pip_spin_lock( &pip_root->lock_ldlinux );
+    /*** begin lock region ***/
+    do {
+      err = pip_load_prog( prog, ulpt );
+    } while( 0 );
+    /*** end lock region ***/
+    pip_spin_unlock( &pip_root->lock_ldlinux );
+  }
 
   if( err == 0 ) {
     void *stack;
@@ -1974,9 +4969,10 @@ int pip_ulp_create( char *prog,
     ulp->termcb = termcb;
     ulp->aux    = aux;
     ulp->pipid  = pipid;
-    if( ( stack = pip_ulp_alloc_stack() ) != NULL ) {
+    if( ( stack = pip_ulp_alloc_stack( stack_size ) ) != NULL ) {
       DBGF( "stack=%p", stack );
-      ulpt->stack = stack;
+      ulpt->stack      = stack;
+      ulpt->stack_size = stack_size;
       goto done;
     } else {
       err = ENOMEM;
@@ -1987,11 +4983,12 @@ int pip_ulp_create( char *prog,
   if( args != NULL ) {
     if( args->prog  != NULL ) free( args->prog );
     if( args->argv  != NULL ) free( args->argv );
-    if( args->envv  != NULL ) free( args->envv );
+    pip_free_env( args );
   }
   if( ulpt != NULL ) {
-    if( ulpt->loaded != NULL ) (void) pip_dlclose( ulpt->loaded );
+    (void) pip_unload_prog( ulpt );
     pip_init_task_struct( ulpt );
+    pip_free_task_slot( pipid );
   }
  done:
   DBGF( "<< pip_ulp_create()=%d", err );
@@ -2045,6 +5042,7 @@ static void pip_ulp_main_( int pipid, int root_H, int root_L ) {
 			 ulpt->args.envv,
 			 NULL,
 			 0 );
+  pip_shared_resolve_tls( ulpt->shared );
 
 #ifdef PRINT_MAPS
   pip_print_maps();
@@ -2055,6 +5053,7 @@ static void pip_ulp_main_( int pipid, int root_H, int root_L ) {
   if( !flag ) {
     flag = 1;
     ulpt->ctx_exit = &ctx;
+    ulpt->flag_main = PIP_MAIN_ENTERED;
 
     DBGF( "[ULP] >> main@%p(%d,%s,%s,...)",
 	  ulpt->symbols.main, argc, ulpt->args.argv[0], ulpt->args.argv[1] );
@@ -2067,8 +5066,8 @@ static void pip_ulp_main_( int pipid, int root_H, int root_L ) {
 
   pip_glibc_fin( &ulpt->symbols );
 
-  pip_ulp_recycle_stack( ulpt->stack );
-  ulpt->stack       = NULL;
+  /* still running on the stack, it is recycled when finalized */
+  ulpt->flag_main   = PIP_MAIN_RETURNED;
   ulpt->task_parent = NULL;
   ulp->termcb	    = NULL;
   ulp->aux 	    = NULL;
@@ -2098,9 +5097,9 @@ int pip_ulp_yield_to( pip_ulp_t *oldulp, pip_ulp_t *newulp ) {
     getcontext( &newctx );	/* to reset newctx */
     DBG;
     newctx.uc_link = NULL;
-    stk->ss_sp     = pip_root->tasks[newulp->pipid].stack;
+    stk->ss_sp     = pip_task_at( newulp->pipid )->stack;
     stk->ss_flags  = 0;
-    stk->ss_size   = pip_root->stack_size;
+    stk->ss_size   = pip_task_at( newulp->pipid )->stack_size;
     root_H = ( ((intptr_t) pip_root) >> 32 ) & MASK32;
     root_L = ((intptr_t) pip_root) & MASK32;
     DBGF( "pip_root=%p  (0x%x 0x%x)", pip_root, root_H, root_L );
@@ -2114,6 +5113,8 @@ int pip_ulp_yield_to( pip_ulp_t *oldulp, pip_ulp_t *newulp ) {
   }
   DBG;
   if( oldulp != NULL ) oldulp->ctx = &oldctx;
+  /* nothing but swapcontext() may run after this */
+  pip_ulp_switch_ns( pip_task_at( newulp->pipid ) );
   if( swapcontext( &oldctx, newulp->ctx ) != 0 ) err = errno;
   DBG;
   if( err != 0 ) {
@@ -2139,7 +5140,10 @@ int pip_ulp_do_finalize( int pipid, int *retvalp ) {
   if( ( err = pip_check_pipid( &pipid ) ) != 0 ) RETURN( err );
   ulp = pip_get_task_( pipid );
   if( ulp->type != PIP_TYPE_ULP ) RETURN( EPERM );
-  pip_ulp_recycle_stack( ulp->stack );
+  /* a ULP scheduled once must have returned from main() */
+  if( ulp->flag_main == PIP_MAIN_ENTERED ) RETURN( EBUSY );
+  pip_ulp_recycle_stack( ulp->stack, ulp->stack_size );
+  ulp->stack = NULL;
   pip_finalize_task( ulp, retvalp ); /* FIXME: this violates the rule */
   RETURN( err );
 }
@@ -63,6 +63,17 @@ int(*clone_syscall_t)(int(*)(void*), void*, int, void*, pid_t*, void*, pid_t*);
 
 static clone_syscall_t pip_clone_orig = NULL;
 
+/* the request of the calling thread, if PiP is spawning a task by it */
+static pip_clone_req_t *pip_find_request( pid_t tid ) {
+  int i;
+
+  if( pip_clone_info.nreqs == 0 ) return NULL;
+  for( i=0; i<PIP_CLONE_NREQS; i++ ) {
+    if( pip_clone_info.reqs[i].tid == tid ) return &pip_clone_info.reqs[i];
+  }
+  return NULL;
+}
+
 int __clone( int(*fn)(void*), void *child_stack, int flags, void *args, ... ) {
   pid_t pip_gettid( void ) {
     return (pid_t) syscall( (long int) SYS_gettid );
@@ -74,117 +85,90 @@ int __clone( int(*fn)(void*), void *child_stack, int flags, void *args, ... ) {
     return pip_clone_orig;
   }
 
-  pid_t		 tid = pip_gettid();
-  pip_spinlock_t oldval;
-  int 		 retval = -1;
+  pid_t		  tid = pip_gettid();
+  pip_clone_req_t *req;
+  int 		  retval = -1;
+  va_list	  ap;
 
   DBGF( "tid=%d", tid );
-  while( 1 ) {
-    oldval = pip_spin_trylock_wv( &pip_clone_info.lock, PIP_LOCK_OTHERWISE );
-    DBGF( "oldval=%d", oldval );
-    switch( oldval ) {
-    case PIP_LOCK_UNLOCKED:
-      /* lock succeeded */
-      DBG;
-      goto lock_ok;
-    case PIP_LOCK_OTHERWISE:
-      /* busy-waiting */
-      DBG;
-      continue;
-    default:
-      if( oldval == tid ) {
-	DBG;
-	goto lock_ok; /* locked by myself */
-      }
-      DBG;
-      break;
+  va_start( ap, args );
+  pid_t *ptid = va_arg( ap, pid_t*);
+  void  *tls  = va_arg( ap, void*);
+  pid_t *ctid = va_arg( ap, pid_t*);
+  va_end( ap );
+
+  if( pip_clone_orig == NULL ) {
+    if( ( pip_clone_orig = pip_get_clone() ) == NULL ) {
+      DBGF( "!!! Original clone() NOT FOUND" );
+      errno = ENOSYS;
+      return -1;
     }
   }
- lock_ok:
-  {
-    va_list ap;
-    va_start( ap, args );
-    pid_t *ptid = va_arg( ap, pid_t*);
-    void  *tls  = va_arg( ap, void*);
-    pid_t *ctid = va_arg( ap, pid_t*);
-
-    if( pip_clone_orig == NULL ) {
-      if( ( pip_clone_orig = pip_get_clone() ) == NULL ) {
-	DBGF( "!!! Original clone() NOT FOUND" );
-	errno = ENOSYS;
-	goto error;
-      }
-    }
-    if( oldval == PIP_LOCK_UNLOCKED ) {
-      DBGF( "!!! Original clone() is used" );
-      retval = pip_clone_orig( fn, child_stack, flags, args, ptid, tls, ctid);
+  /* clone()s not requested by PiP pass through without any lock */
+  if( ( req = pip_find_request( tid ) ) == NULL ) {
+    DBGF( "!!! Original clone() is used" );
+    retval = pip_clone_orig( fn, child_stack, flags, args, ptid, tls, ctid);
 
 #ifdef CHECK_TLS
 #ifdef __x86_64__
-      if( flags & CLONE_SETTLS ) {
-	unsigned long fsaddr;
-	arch_prctl( ARCH_GET_FS, &fsaddr );
-	pip_print_maps();
-	fprintf( stderr,
-		 "TLS=%p  tls.base_addr=%u  FS=%p  PThread=%p  STACK=%p\n",
-		 (void*) tls, ((struct user_desc *) tls)->base_addr,
-		 (void*) fsaddr, (void*) pthread_self(), child_stack );
-      } else {
-	fprintf( stderr, "CLONE_SETTLS is not set\n" );
-      }
+    if( flags & CLONE_SETTLS ) {
+      unsigned long fsaddr;
+      arch_prctl( ARCH_GET_FS, &fsaddr );
+      pip_print_maps();
+      fprintf( stderr,
+	       "TLS=%p  tls.base_addr=%u  FS=%p  PThread=%p  STACK=%p\n",
+	       (void*) tls, ((struct user_desc *) tls)->base_addr,
+	       (void*) fsaddr, (void*) pthread_self(), child_stack );
+    } else {
+      fprintf( stderr, "CLONE_SETTLS is not set\n" );
+    }
 #endif
 #endif
 
-    } else if( oldval == tid ) {
-      DBGF( "!!! clone() wrapper" );
+  } else {
+    DBGF( "!!! clone() wrapper" );
 #ifdef DEBUG
-      int oldflags = flags;
+    int oldflags = flags;
 #endif
 
-      flags &= ~(CLONE_FS);	 /* 0x00200 */
-      flags &= ~(CLONE_FILES);	 /* 0x00400 */
-      flags &= ~(CLONE_SIGHAND); /* 0x00800 */
-      flags &= ~(CLONE_THREAD);	 /* 0x10000 */
-      flags &= ~0xff;
-      flags |= SIGCHLD;
-      flags |= CLONE_VM;
-      /* do not reset the CLONE_SETTLS flag */
-      flags |= CLONE_SETTLS;
-      flags |= CLONE_PTRACE;
-
-      errno = 0;
-      DBGF( ">>>> clone(flags: 0x%x -> 0x%x)@%p  STACK=%p, TLS=%p",
-	    oldflags, flags, fn, child_stack, tls );
-      retval = pip_clone_orig( fn, child_stack, flags, args, ptid, tls, ctid );
-      DBGF( "<<<< clone()=%d (errno=%d)", retval, errno );
+    flags &= ~(CLONE_FS);	 /* 0x00200 */
+    flags &= ~(CLONE_FILES);	 /* 0x00400 */
+    flags &= ~(CLONE_SIGHAND); /* 0x00800 */
+    flags &= ~(CLONE_THREAD);	 /* 0x10000 */
+    flags &= ~0xff;
+    flags |= SIGCHLD;
+    flags |= CLONE_VM;
+    /* do not reset the CLONE_SETTLS flag */
+    flags |= CLONE_SETTLS;
+    flags |= CLONE_PTRACE;
+
+    errno = 0;
+    DBGF( ">>>> clone(flags: 0x%x -> 0x%x)@%p  STACK=%p, TLS=%p",
+	  oldflags, flags, fn, child_stack, tls );
+    retval = pip_clone_orig( fn, child_stack, flags, args, ptid, tls, ctid );
+    DBGF( "<<<< clone()=%d (errno=%d)", retval, errno );
 
 #ifdef CHECK_TLS
 #ifdef __x86_64__
-      if( flags & CLONE_SETTLS ) {
-	unsigned long fsaddr;
-	arch_prctl( ARCH_GET_FS, &fsaddr );
-	pip_print_maps();
-	fprintf( stderr,
-		 "TLS=%p  tls.base_addr=%u  FS=%p  PThread=%p  STACK=%p\n",
-		 (void*) tls, ((struct user_desc *) tls)->base_addr,
-		 (void*) fsaddr, (void*) pthread_self(), child_stack );
-      } else {
-	fprintf( stderr, "CLONE_SETTLS is not set\n" );
-      }
+    if( flags & CLONE_SETTLS ) {
+      unsigned long fsaddr;
+      arch_prctl( ARCH_GET_FS, &fsaddr );
+      pip_print_maps();
+      fprintf( stderr,
+	       "TLS=%p  tls.base_addr=%u  FS=%p  PThread=%p  STACK=%p\n",
+	       (void*) tls, ((struct user_desc *) tls)->base_addr,
+	       (void*) fsaddr, (void*) pthread_self(), child_stack );
+    } else {
+      fprintf( stderr, "CLONE_SETTLS is not set\n" );
+    }
 #endif
 #endif
 
-      if( retval > 0 ) {	/* created PID is returned */
-	pip_clone_info.flag_clone = flags;
-	pip_clone_info.pid_clone  = retval;
-	pip_clone_info.stack      = child_stack;
-      }
-    } else {
-      DBGF( "!!! wrpper clone() ??????" );
+    if( retval > 0 ) {	/* created PID is returned */
+      pip_clone_info.flag_clone = flags;
+      pip_clone_info.stack      = child_stack;
+      req->pid_clone            = retval;
     }
-    va_end( ap );
   }
- error:
-  pip_spin_unlock( &pip_clone_info.lock );
   return retval;
 }
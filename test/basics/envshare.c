@@ -0,0 +1,92 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define ENVNAME		"PIP_TEST_SHAREENV"
+#define ENVVAL		"all tasks have the same one"
+
+static int task_main( char *argp ) {
+  char	**ptrs = (char**) strtoul( argp, NULL, 16 );
+  char	*env;
+  int	pipid;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  if( ( env = getenv( ENVNAME ) ) == NULL ||
+      strcmp( env, ENVVAL ) != 0 ) return 1;
+  ptrs[pipid] = env;
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  char	*nargv[3], *envv[3], ptr[32];
+  char	*ptrs[NTASKS];
+  int	pipid, ntasks, status, i;
+
+  if( argc == 2 && pip_isa_piptask() ) return task_main( argv[1] );
+
+  ntasks = NTASKS;
+  TESTINT( pip_init( &pipid, &ntasks, NULL, PIP_OPT_SHAREENV ) );
+  sprintf( ptr, "%lx", (unsigned long) ptrs );
+  nargv[0] = argv[0];
+  nargv[1] = ptr;
+  nargv[2] = NULL;
+  envv[0]  = ENVNAME "=" ENVVAL;
+  envv[1]  = "PATH=/bin:/usr/bin";
+  envv[2]  = NULL;
+  for( i=0; i<ntasks; i++ ) {
+    ptrs[i] = NULL;
+    pipid = i;
+    if( pip_spawn( argv[0], nargv, envv, PIP_CPUCORE_ASIS, &pipid,
+		   NULL, NULL, NULL ) != 0 ) break;
+  }
+  ntasks = i;
+  for( i=0; i<ntasks; i++ ) {
+    TESTINT( pip_wait( i, &status ) );
+    if( status != 0 ) {
+      fprintf( stderr, "[%d] getenv() failed\n", i );
+      exit( 1 );
+    }
+  }
+  for( i=0; i<ntasks; i++ ) {
+    /* the string is not the one passed, but the one in the block */
+    if( ptrs[i] == NULL || ptrs[i] == envv[0] + strlen( ENVNAME ) + 1 ||
+	ptrs[i] != ptrs[0] ) {
+      fprintf( stderr, "[%d] %p is not shared (%p)\n",
+	       i, ptrs[i], ptrs[0] );
+      exit( 1 );
+    }
+    fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), i );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#define PIP_INTERNAL_FUNCS
+#include <test.h>
+
+/* odd tasks are spawned with PIP_SPAWN_ATTR_CLOEXEC, even ones without */
+/* it, which must not close the FD_CLOEXEC one (no /proc/self/fd scan)  */
+int main( int argc, char **argv ) {
+  pip_spawn_attr_t	attr, attr_coe;
+  char			*nargv[6], fdstr[16], dupstr[16], coestr[16];
+  int			pipid, ntasks, fd, dupfd, coefd, shared, closed, i;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  if( pipid == PIP_PIPID_ROOT ) {
+    if( argc < 2 ) {
+      fprintf( stderr, "fileaction <ntasks>\n" );
+      exit( 1 );
+    }
+    ntasks = atoi( argv[1] );
+    if( ntasks <= 0 || ntasks > NTASKS ) {
+      fprintf( stderr, "Illegal number of tasks is specified.\n" );
+      exit( 1 );
+    }
+    TESTSYSERR( fd    = open( "/dev/null", O_RDONLY ) );
+    TESTSYSERR( coefd = open( "/dev/null", O_RDONLY | O_CLOEXEC ) );
+    dupfd = fd + 10;
+    sprintf( fdstr,  "%d", fd    );
+    sprintf( dupstr, "%d", dupfd );
+    sprintf( coestr, "%d", coefd );
+    nargv[0] = argv[0];
+    nargv[1] = "-";
+    nargv[2] = fdstr;
+    nargv[3] = dupstr;
+    nargv[4] = coestr;
+    nargv[5] = NULL;
+
+    TESTINT( pip_spawn_attr_init( &attr ) );
+    TESTINT( pip_spawn_attr_adddup2( &attr, fd, dupfd ) );
+    TESTINT( pip_spawn_attr_addclose( &attr, fd ) );
+    TESTINT( pip_spawn_attr_init( &attr_coe ) );
+    TESTINT( pip_spawn_attr_adddup2( &attr_coe, fd, dupfd ) );
+    TESTINT( pip_spawn_attr_addclose( &attr_coe, fd ) );
+    TESTINT( pip_spawn_attr_setflags( &attr_coe, PIP_SPAWN_ATTR_CLOEXEC ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn_ex( argv[0], nargv, NULL, i % cpu_num_limit(),
+			     &pipid, NULL, NULL, NULL,
+			     ( i & 1 ) ? &attr_coe : &attr ) );
+    }
+    TESTINT( pip_spawn_attr_destroy( &attr ) );
+    TESTINT( pip_spawn_attr_destroy( &attr_coe ) );
+    for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+    TESTINT( pip_fin() );
+
+  } else {
+    fd     = atoi( argv[2] );
+    dupfd  = atoi( argv[3] );
+    coefd  = atoi( argv[4] );
+    closed = ( fcntl( coefd, F_GETFD ) == -1 );
+    TESTINT( pip_is_shared_fd( &shared ) );
+    if( !shared &&
+	( fcntl( fd, F_GETFD ) != -1 || fcntl( dupfd, F_GETFD ) == -1 ) ) {
+      fprintf( stderr, "<%d> file actions are not taken !!!!\n", pipid );
+    } else if( !shared && closed != ( pipid & 1 ) ) {
+      fprintf( stderr, "<%d> FD_CLOEXEC fd is %s !!!!\n", pipid,
+	       closed ? "closed" : "not closed" );
+    } else {
+      fprintf( stderr, "<%d> Hello, I am fine !!\n", pipid );
+    }
+  }
+  return 0;
+}
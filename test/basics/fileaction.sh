@@ -0,0 +1,5 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+$MCEXEC ./fileaction $TEST_PIP_TASKS 2>&1 | test_msg_count 'Hello, I am fine !!' $TEST_PIP_TASKS
@@ -80,6 +80,22 @@ void check_vars( int pipid ) {
   }
 }
 
+/* pip_get_addr_all() must agree with pip_get_addr() of each task */
+void check_all( int ntasks ) {
+  void *addrs[ntasks], *addr;
+  int i;
+
+  TESTINT( pip_get_addr_all( "var_pointers", addrs, ntasks ) );
+  for( i=0; i<ntasks; i++ ) {
+    TESTINT( pip_get_addr( i, "var_pointers", &addr ) );
+    if( addrs[i] != addr ) {
+      printf( "%20s [%d] var_pointers: %p !!!!=== %p !!!!\n",
+	      tag, i, addrs[i], addr );
+      error = 1;
+    }
+  }
+}
+
 struct task_comm {
   pthread_mutex_t	mutex;
   pthread_barrier_t	barrier;
@@ -157,6 +173,8 @@ int main( int argc, char **argv ) {
       for( i=pipid; i<ntasks; i++ ) pthread_barrier_wait( barrp );
     }
     check_vars( pipid );
+    check_vars( pipid );	/* hits the symbol cache */
+    check_all( ntasks );
     pthread_barrier_wait( barrp );
     if( !error ) {
       printf( "%s Hello, I am just fine !!\n", tag );
@@ -0,0 +1,152 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+#include <pip_ulp.h>
+
+extern int pip_ulp_do_finalize( int, int* );
+
+/* more than a segment of the task table (64 entries) */
+#define NULPS		(100)
+#define PIPID_BEYOND	(100)
+
+typedef struct {
+  pip_ulp_t		task;
+  pip_ulp_t		ulp[NULPS];
+  int			done[NULPS];
+} ulp_comm_t;
+
+typedef struct {
+  ulp_comm_t		*comm;
+  int			idx;
+} ulp_arg_t;
+
+static int ulp_main( char *argp ) {
+  ulp_arg_t	*arg = (ulp_arg_t*) strtoul( argp, NULL, 16 );
+  int		pipid;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  return arg->idx;
+}
+
+/* called on the stack of the terminated ULP */
+static void termcb( void *aux ) {
+  ulp_arg_t *arg = (ulp_arg_t*) aux;
+
+  arg->comm->done[arg->idx] = 1;
+  (void) pip_ulp_yield_to( NULL, &arg->comm->task );
+}
+
+/* PIP_PIPID_ANY must grow the table when the current one is full */
+static int ulp_host( char *prog, int pipid ) {
+  static ulp_comm_t	comm;
+  static ulp_arg_t	args[NULPS];
+  static char		ptr[NULPS][32];
+  static char		*nargv[NULPS][4];
+  int			pipids[NULPS];
+  int			retval, max = 0, i;
+
+  TESTINT( pip_make_ulp( PIP_PIPID_MYSELF, NULL, NULL, &comm.task ) );
+  for( i=0; i<NULPS; i++ ) {
+    args[i].comm = &comm;
+    args[i].idx  = i;
+    comm.done[i] = 0;
+    sprintf( ptr[i], "%lx", (unsigned long) &args[i] );
+    nargv[i][0] = prog;
+    nargv[i][1] = "-u";
+    nargv[i][2] = ptr[i];
+    nargv[i][3] = NULL;
+    pipids[i] = PIP_PIPID_ANY;
+    TESTINT( pip_ulp_create( prog, nargv[i], NULL, &pipids[i],
+			     termcb, &args[i], &comm.ulp[i] ) );
+    if( pipids[i] > max ) max = pipids[i];
+  }
+  if( max < NULPS ) {
+    fprintf( stderr, "[%d] the largest PIPID is %d\n", pipid, max );
+    return 1;
+  }
+  for( i=0; i<NULPS; i++ ) {
+    while( !comm.done[i] ) {
+      TESTINT( pip_ulp_yield_to( &comm.task, &comm.ulp[i] ) );
+    }
+    TESTINT( pip_ulp_do_finalize( pipids[i], &retval ) );
+    if( retval != i ) {
+      fprintf( stderr, "[%d] ULP[%d] returns %d\n", pipid, i, retval );
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int task_main( char *prog, char *expected ) {
+  int pipid;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  if( pipid != atoi( expected ) ) {
+    fprintf( stderr, "PIPID %d != %s\n", pipid, expected );
+    return 1;
+  }
+  if( pipid == 0 && ulp_host( prog, pipid ) != 0 ) return 1;
+  fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  int	pipids[] = { 0, PIPID_BEYOND, PIP_NTASKS_MAX - 1 };
+  int	ntasks = sizeof(pipids) / sizeof(int);
+  char	*nargv[3], expected[16];
+  int	pipid, status, i;
+
+  if( argc == 3 && strcmp( argv[1], "-u" ) == 0 ) return ulp_main( argv[2] );
+  if( argc == 2 && pip_isa_piptask() ) return task_main( argv[0], argv[1] );
+
+  /* NULL ntasks, the task table grows on demand */
+  TESTINT( pip_init( &pipid, NULL, NULL, PIP_OPT_ULPSHARE_EXPERIMENTAL ) );
+  nargv[0] = argv[0];
+  nargv[1] = expected;
+  nargv[2] = NULL;
+  for( i=0; i<ntasks; i++ ) {
+    sprintf( expected, "%d", pipids[i] );
+    pipid = pipids[i];
+    TESTINT( pip_spawn( argv[0], nargv, NULL, PIP_CPUCORE_ASIS, &pipid,
+			NULL, NULL, NULL ) );
+    if( pipid != pipids[i] ) {
+      fprintf( stderr, "pip_spawn(%d!=%d) !!!!!!\n", pipids[i], pipid );
+      exit( 1 );
+    }
+    /* one by one, so that the ULPs of the first one grow the table */
+    TESTINT( pip_wait( pipids[i], &status ) );
+    if( status != 0 ) exit( 1 );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,5 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+$MCEXEC ./growth 2>&1 | test_msg_count 'Hello, my PIPID is ' 3
@@ -40,11 +40,12 @@
 #include <test.h>
 
 struct comm_st {
-  pthread_barrier_t barrier;
-  int	go;
+  pthread_mutex_t	mutex;
+  pthread_cond_t	cond;
+  int			go;
 };
 
-struct comm_st	comm;
+struct comm_st	comm = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
 
 int assign_core( void ) {
   static int init = 0;
@@ -79,6 +80,8 @@ int assign_core( void ) {
 }
 
 int main( int argc, char **argv ) {
+  pip_spawn_handle_t handles[NTASKS];
+  int ok[NTASKS];
   struct comm_st *commp;
   void *exp;
   char corestr[32];
@@ -102,35 +105,34 @@ int main( int argc, char **argv ) {
 
       fprintf( stderr, "Spawning task[%d] on %s\n", i, corestr );
 
-      err = pip_spawn( nargv[0], nargv, NULL, core, &pipid, NULL, NULL, NULL );
+      err = pip_spawn_async( nargv[0], nargv, NULL, core, &pipid,
+			     NULL, NULL, NULL, &handles[i] );
       if( err != 0 ) break;
       if( i != pipid ) {
 	fprintf( stderr, "pip_spawn(%d!=%d) !!!!!!\n", i, pipid );
       }
     }
     ntasks = i;
-    TESTINT( pthread_barrier_init( &comm.barrier, NULL, ntasks+1 ) );
-    comm.go = 1;
-    pthread_barrier_wait( &comm.barrier );
+    /* all the tasks are in main() and alive until they are let go */
+    for( i=0; i<ntasks; i++ ) ok[i] = ( pip_spawn_wait( handles[i] ) == 0 );
     print_numa();
     fflush( NULL );
-    comm.go = 0;
-    pthread_barrier_wait( &comm.barrier );
+    pthread_mutex_lock( &comm.mutex );
+    comm.go = 1;
+    pthread_cond_broadcast( &comm.cond );
+    pthread_mutex_unlock( &comm.mutex );
 
     fprintf( stderr, "Root: done\n" );
 
-    for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+    for( i=0; i<ntasks; i++ ) if( ok[i] ) TESTINT( pip_wait( i, NULL ) );
     TESTINT( pip_fin() );
 
   } else {
     commp = (struct comm_st*) exp;
     TESTINT( pip_export( &comm ) );
-    while( 1 ) {
-      if( commp->go ) break;
-      pause_and_yield( 10 );
-    }
-    pthread_barrier_wait( &commp->barrier );
-    pthread_barrier_wait( &commp->barrier );
+    pthread_mutex_lock( &commp->mutex );
+    while( !commp->go ) pthread_cond_wait( &commp->cond, &commp->mutex );
+    pthread_mutex_unlock( &commp->mutex );
   }
   return 0;
 }
@@ -0,0 +1,104 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <sys/syscall.h>
+#include <test.h>
+
+#define NPAGES		(4)
+#define PAGESZ		(4096)
+
+static char data[NPAGES*PAGESZ];
+
+/* the pages must be on the node, if they are there */
+static int check_node( const char *what, char *addr, int node ) {
+  void	*pages[NPAGES];
+  int	status[NPAGES];
+  int	i;
+
+  for( i=0; i<NPAGES; i++ ) {
+    addr[i*PAGESZ] = i;		/* touch it */
+    pages[i] = &addr[i*PAGESZ];
+  }
+  /* with NULL nodes, move_pages() only queries where they are */
+  if( syscall( SYS_move_pages, 0, NPAGES, pages, NULL, status, 0 ) != 0 ) {
+    fprintf( stderr, "move_pages(): %s\n", strerror( errno ) );
+    return 1;
+  }
+  for( i=0; i<NPAGES; i++ ) {
+    if( status[i] >= 0 && status[i] != node ) {
+      fprintf( stderr, "%s page[%d] is on node %d, not on %d\n",
+	       what, i, status[i], node );
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int task_main( void ) {
+  char		stack[NPAGES*PAGESZ];
+  unsigned int	cpu, node;
+  int		pipid;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  TESTSYSERR( syscall( SYS_getcpu, &cpu, &node, NULL ) );
+  TESTINT( pip_numa_report( stderr ) );
+  if( check_node( "data",  data,  node ) ||
+      check_node( "stack", stack, node ) ) return 1;
+  fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  char	*nargv[] = { argv[0], NULL };
+  int	pipid, ntasks, nspawn, status, i;
+
+  if( pip_isa_piptask() ) return task_main();
+
+  ntasks = NTASKS;
+  nspawn = NTASKS;
+  if( argc > 1 && atoi( argv[1] ) > 0 && atoi( argv[1] ) < NTASKS ) {
+    nspawn = atoi( argv[1] );
+  }
+  TESTINT( pip_init( &pipid, &ntasks, NULL, PIP_OPT_NUMABIND ) );
+  for( i=0; i<nspawn; i++ ) {
+    pipid = i;
+    if( pip_spawn( argv[0], nargv, NULL, i % cpu_num_limit(),
+		   &pipid, NULL, NULL, NULL ) != 0 ) break;
+  }
+  nspawn = i;
+  for( i=0; i<nspawn; i++ ) {
+    TESTINT( pip_wait( i, &status ) );
+    if( status != 0 ) exit( 1 );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
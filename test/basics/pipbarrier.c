@@ -0,0 +1,101 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define NTIMES		(100)
+
+static int types[] = {
+  PIP_BARRIER_CENTRAL,
+  PIP_BARRIER_DISSEMINATION,
+  PIP_BARRIER_TOURNAMENT,
+  PIP_BARRIER_TREE,
+};
+#define NTYPES		(sizeof(types)/sizeof(types[0]))
+
+struct barrier_comm {
+  pip_barrier_t		barrier[NTYPES];
+  volatile int		count[NTYPES];
+};
+
+static int run( struct barrier_comm *bc, int nparts, int pipid ) {
+  int t, i;
+
+  for( t=0; t<NTYPES; t++ ) {
+    for( i=0; i<NTIMES; i++ ) {
+      (void) __sync_fetch_and_add( &bc->count[t], 1 );
+      pip_barrier_wait( &bc->barrier[t] );
+      /* everyone has counted up before anyone leaves the barrier */
+      if( bc->count[t] != nparts * ( i + 1 ) ) {
+	fprintf( stderr, "[%d] type=%d iteration=%d: count=%d\n",
+		 pipid, types[t], i, bc->count[t] );
+	return 1;
+      }
+      pip_barrier_wait( &bc->barrier[t] );
+    }
+  }
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  struct barrier_comm	bc, *bcp;
+  int pipid, ntasks, t, i, err;
+
+  ntasks = NTASKS;
+  if( !pip_isa_piptask() ) {
+    memset( &bc, 0, sizeof(bc) );
+    for( t=0; t<NTYPES; t++ ) {
+      TESTINT( pip_barrier_init_ex( &bc.barrier[t], ntasks + 1, types[t] ) );
+    }
+    if( pip_barrier_init_ex( &bc.barrier[0], ntasks + 1, -1 ) != EINVAL ) {
+      fprintf( stderr, "pip_barrier_init_ex() accepts an invalid type\n" );
+    }
+  }
+  bcp = &bc;
+  TESTINT( pip_init( &pipid, &ntasks, (void**) &bcp, 0 ) );
+  if( pipid == PIP_PIPID_ROOT ) {
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, i % cpu_num_limit(),
+			  &pipid, NULL, NULL, NULL ) );
+    }
+    err = run( bcp, ntasks + 1, PIP_PIPID_ROOT );
+    for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+    for( t=0; t<NTYPES; t++ ) pip_barrier_fin( &bc.barrier[t] );
+    TESTINT( pip_fin() );
+    if( err ) return 1;
+  } else {
+    if( run( bcp, ntasks + 1, pipid ) ) return 1;
+    fprintf( stderr, "<%d> Hello, I am fine !!\n", pipid );
+  }
+  return 0;
+}
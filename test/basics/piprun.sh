@@ -0,0 +1,48 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+PIPRUN=../../bin/piprun
+[ -x $PIPRUN ] || exit $EXIT_UNSUPPORTED
+
+trap 'rm -f $TEST_TMP; exit $EXIT_KILLED' $TEST_TRAP_SIGS
+
+NCPUS=$(getconf _NPROCESSORS_ONLN)
+N=$TEST_PIP_TASKS
+[ $N -gt $NCPUS ] && N=$NCPUS
+NSOCKETS=$(cat /sys/devices/system/cpu/cpu*/topology/physical_package_id \
+	   2>/dev/null | sort -u | wc -l)
+
+# socket_of <pipid>: the socket reported for the PiP task
+socket_of()
+{
+	sed -n "s/^.*PIPID\[$1\] bound to core [0-9]* (socket \([0-9]*\),.*$/\1/p" \
+	    <$TEST_TMP
+}
+
+# check_bindings <policy>: every PiP task is reported, and bound to a
+# different core unless there are more PiP tasks than the cores
+check_bindings()
+{
+	$MCEXEC $PIPRUN -n $N -p $1 --report-bindings ./null >$TEST_TMP 2>&1
+	[ $(fgrep 'bound to core' <$TEST_TMP | wc -l) -eq $N ] || return 1
+	[ $(sed -n 's/^.*bound to core \([0-9]*\) .*$/\1/p' <$TEST_TMP |
+	    sort -u | wc -l) -eq $N ] || return 1
+	[ $(fgrep 'Hello, I am fine !!' <$TEST_TMP | wc -l) -eq $N ]
+}
+
+test_exit_status=$EXIT_FAIL
+if check_bindings compact; then
+	# the first two PiP tasks share a socket
+	if [ $N -lt 2 ] || [ "$(socket_of 0)" = "$(socket_of 1)" ]; then
+		if check_bindings scatter; then
+			# and they are placed on different sockets, if any
+			if [ $N -lt 2 ] || [ $NSOCKETS -lt 2 ] ||
+			   [ "$(socket_of 0)" != "$(socket_of 1)" ]; then
+				test_exit_status=$EXIT_PASS
+			fi
+		fi
+	fi
+fi
+rm -f $TEST_TMP
+exit $test_exit_status
@@ -0,0 +1,78 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define WAIT_MAX	(60*1000)	/* 60 seconds in milliseconds */
+
+int main( int argc, char **argv ) {
+  char	*nargv[] = { "./null", NULL };
+  int	pipid, ntasks, size, hits, misses, i;
+
+  if( argc < 2 ) {
+    fprintf( stderr, "pool <ntasks>\n" );
+    exit( 1 );
+  }
+  ntasks = atoi( argv[1] );
+  if( ntasks <= 0 || ntasks > NTASKS ) {
+    fprintf( stderr, "Illegal number of tasks is specified.\n" );
+    exit( 1 );
+  }
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  TESTINT( pip_pool_prepare( nargv[0], ntasks ) );
+  for( i=0; i<WAIT_MAX; i++ ) {
+    TESTINT( pip_pool_stats( &size, NULL, NULL ) );
+    if( size >= ntasks ) break;
+    usleep( 1000 );
+  }
+  if( size < ntasks ) {
+    fprintf( stderr, "pool: only %d/%d are loaded !!!!!!\n", size, ntasks );
+    exit( 1 );
+  }
+
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    TESTINT( pip_spawn( nargv[0], nargv, NULL, i % cpu_num_limit(),
+			&pipid, NULL, NULL, NULL ) );
+  }
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+
+  TESTINT( pip_pool_stats( &size, &hits, &misses ) );
+  if( size != 0 || hits != ntasks || misses != 0 ) {
+    fprintf( stderr, "pool: size=%d hits=%d misses=%d !!!!!!\n",
+	     size, hits, misses );
+    exit( 1 );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,54 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define NSPAWNS		(PIP_NTASKS_MAX+10)
+
+int main( int argc, char **argv ) {
+  char	*nargv[] = { "./null", NULL };
+  int	pipid, ntasks = 1, hits, misses, i;
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, PIP_OPT_RECYCLE ) );
+  /* more than PIP_NTASKS_MAX namespaces are required without recycling */
+  for( i=0; i<NSPAWNS; i++ ) {
+    pipid = 0;
+    TESTINT( pip_spawn( nargv[0], nargv, NULL, 0, &pipid, NULL, NULL, NULL ));
+    TESTINT( pip_wait( pipid, NULL ) );
+  }
+  TESTINT( pip_pool_stats( NULL, &hits, &misses ) );
+  if( hits != NSPAWNS - 1 || misses != 1 ) {
+    fprintf( stderr, "recycle: hits=%d misses=%d !!!!!!\n", hits, misses );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,5 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+$MCEXEC ./recycle 2>&1 | test_msg_count 'Hello, I am fine !!' 270
@@ -0,0 +1,86 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define BUFSZ	(16)
+
+int		gvar;
+static int	buf[BUFSZ];
+
+int main( int argc, char **argv ) {
+  void	*addr, *remote;
+  int	pipid, ntasks, next, i;
+
+  ntasks = NTASKS;
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  if( pipid == PIP_PIPID_ROOT ) {
+    for( i=0; i<NTASKS; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, i % cpu_num_limit(),
+			  &pipid, NULL, NULL, NULL ) );
+    }
+    if( pip_remote_addr( 0, &gvar, &remote ) != EPERM ) {
+      fprintf( stderr, "pip_remote_addr() is allowed for the root\n" );
+    }
+    for( i=0; i<NTASKS; i++ ) {
+      TESTINT( pip_named_import( i, "done", &addr, NULL, NULL ) );
+    }
+    for( i=0; i<NTASKS; i++ ) TESTINT( pip_wait( i, NULL ) );
+    TESTINT( pip_fin() );
+  } else {
+    gvar = pipid;
+    for( i=0; i<BUFSZ; i++ ) buf[i] = pipid * 100 + i;
+    TESTINT( pip_named_export( "ready", NULL, 0 ) );
+    next = ( pipid + 1 ) % ntasks;
+    TESTINT( pip_named_import( next, "ready", &addr, NULL, NULL ) );
+
+    TESTINT( pip_get_addr( next, "gvar", &addr ) );
+    TESTINT( pip_remote_addr( next, &gvar, &remote ) );
+    if( addr != remote ) {
+      fprintf( stderr, "[%d] gvar %p != %p\n", pipid, addr, remote );
+      return 1;
+    }
+    TESTINT( pip_remote_addr( next, &buf[BUFSZ/2], &remote ) );
+    if( *(int*)remote != next * 100 + BUFSZ/2 ) {
+      fprintf( stderr, "[%d] buf=%d\n", pipid, *(int*)remote );
+      return 1;
+    }
+    if( pip_remote_addr( next, &i, &remote ) != EFAULT ) {
+      fprintf( stderr, "pip_remote_addr() accepts a stack address\n" );
+      return 1;
+    }
+    TESTINT( pip_named_export( "done", NULL, 0 ) );
+    fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+static int		counter;
+static __thread int	tlsvar;
+
+PIP_SHARED( counter );
+PIP_SHARED_TLS( tlsvar );
+
+static int check( int pipid, char *name, int expected ) {
+  void	*addr;
+  size_t size;
+
+  TESTINT( pip_get_shared( pipid, name, &addr, &size ) );
+  if( size != sizeof(int) ) {
+    fprintf( stderr, "%s@%d: size %lu\n", name, pipid, size );
+    return 1;
+  }
+  if( *(int*)addr != expected ) {
+    fprintf( stderr, "%s@%d: %d != %d\n", name, pipid, *(int*)addr, expected );
+    return 1;
+  }
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  void	*addr;
+  int	pipid, ntasks, next, i;
+
+  ntasks = NTASKS;
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  if( pipid == PIP_PIPID_ROOT ) {
+    counter = -1;
+    tlsvar  = -2;
+    TESTINT( pip_get_shared( PIP_PIPID_ROOT, "counter", &addr, NULL ) );
+    if( addr != (void*) &counter ) {
+      fprintf( stderr, "root: counter %p != %p\n", addr, &counter );
+      exit( 1 );
+    }
+    TESTINT( pip_get_shared( PIP_PIPID_ROOT, "tlsvar", &addr, NULL ) );
+    if( addr != (void*) &tlsvar ) {
+      fprintf( stderr, "root: tlsvar %p != %p\n", addr, &tlsvar );
+      exit( 1 );
+    }
+    if( pip_get_shared( PIP_PIPID_ROOT, "nosuchvar", &addr, NULL )
+	!= ENOENT ) {
+      fprintf( stderr, "pip_get_shared() finds an unregistered name\n" );
+      exit( 1 );
+    }
+    for( i=0; i<NTASKS; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn( argv[0], argv, NULL, i % cpu_num_limit(),
+			  &pipid, NULL, NULL, NULL ) );
+    }
+    for( i=0; i<NTASKS; i++ ) {
+      TESTINT( pip_named_import( i, "done", &addr, NULL, NULL ) );
+    }
+    for( i=0; i<NTASKS; i++ ) TESTINT( pip_wait( i, NULL ) );
+    TESTINT( pip_fin() );
+  } else {
+    counter = pipid * 10;
+    tlsvar  = pipid * 10 + 1;
+    TESTINT( pip_named_export( "ready", NULL, 0 ) );
+    next = ( pipid + 1 ) % ntasks;
+    TESTINT( pip_named_import( next, "ready", &addr, NULL, NULL ) );
+    if( check( next, "counter", next * 10 ) ||
+	check( next, "tlsvar", next * 10 + 1 ) ||
+	check( PIP_PIPID_ROOT, "counter", -1 ) ||
+	check( PIP_PIPID_ROOT, "tlsvar", -2 ) ) return 1;
+    TESTINT( pip_named_export( "done", NULL, 0 ) );
+    fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  }
+  return 0;
+}
@@ -0,0 +1,5 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+$MCEXEC ./shared 2>&1 | test_msg_count 'Hello, my PIPID is '
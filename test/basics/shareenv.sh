@@ -0,0 +1,5 @@
+#!/bin/sh
+
+. ../test.sh.inc
+
+PIP_OPTS=shareenv $MCEXEC ./environ 2>&1 | test_msg_count 'Hello, I am very fine !!'
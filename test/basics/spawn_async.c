@@ -0,0 +1,71 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+int main( int argc, char **argv ) {
+  char			*nargv[] = { "./null", NULL };
+  pip_spawn_handle_t	*handles;
+  int			pipid, ntasks, i, err;
+
+  if( argc < 2 ) {
+    fprintf( stderr, "spawn_async <ntasks>\n" );
+    exit( 1 );
+  }
+  ntasks = atoi( argv[1] );
+  if( ntasks <= 0 || ntasks > NTASKS ) {
+    fprintf( stderr, "Illegal number of tasks is specified.\n" );
+    exit( 1 );
+  }
+  handles = (pip_spawn_handle_t*) malloc( sizeof(pip_spawn_handle_t) * ntasks );
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    TESTINT( pip_spawn_async( nargv[0], nargv, NULL, i % cpu_num_limit(),
+			      &pipid, NULL, NULL, NULL, &handles[i] ) );
+    if( i != pipid ) {
+      fprintf( stderr, "pip_spawn_async(%d!=%d) !!!!!!\n", i, pipid );
+      exit( 1 );
+    }
+  }
+  /* the first one is polled, the others are waited for */
+  while( ( err = pip_spawn_test( handles[0] ) ) == EAGAIN ) {
+    pause_and_yield( 10 );
+  }
+  TESTINT( err );
+  for( i=1; i<ntasks; i++ ) TESTINT( pip_spawn_wait( handles[i] ) );
+
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,78 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+int main( int argc, char **argv ) {
+  char	*nargv[] = { "./null", NULL };
+  char	***argvs;
+  int	*corenos, *pipids, *errs;
+  int	pipid, ntasks, hits, i;
+
+  if( argc < 2 ) {
+    fprintf( stderr, "spawn_n <ntasks>\n" );
+    exit( 1 );
+  }
+  ntasks = atoi( argv[1] );
+  if( ntasks <= 0 || ntasks > NTASKS ) {
+    fprintf( stderr, "Illegal number of tasks is specified.\n" );
+    exit( 1 );
+  }
+  argvs   = (char***) malloc( sizeof(char**) * ntasks );
+  corenos = (int*)    malloc( sizeof(int)    * ntasks );
+  pipids  = (int*)    malloc( sizeof(int)    * ntasks );
+  errs    = (int*)    malloc( sizeof(int)    * ntasks );
+  for( i=0; i<ntasks; i++ ) {
+    argvs[i]   = nargv;
+    corenos[i] = i % cpu_num_limit();
+  }
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  TESTINT( pip_spawn_n( nargv[0], argvs, NULL, corenos, 0, ntasks,
+			pipids, errs ) );
+  for( i=0; i<ntasks; i++ ) {
+    TESTINT( errs[i] );
+    if( pipids[i] != i ) {
+      fprintf( stderr, "pip_spawn_n(%d!=%d) !!!!!!\n", i, pipids[i] );
+      exit( 1 );
+    }
+  }
+  /* all but the first one are loaded ahead by the pool loader */
+  TESTINT( pip_pool_stats( NULL, &hits, NULL ) );
+  if( hits != ntasks - 1 ) {
+    fprintf( stderr, "pip_spawn_n: pool hits=%d !!!!!!\n", hits );
+    exit( 1 );
+  }
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
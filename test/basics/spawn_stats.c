@@ -0,0 +1,69 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+int main( int argc, char **argv ) {
+  char			*nargv[] = { "./null", NULL };
+  pip_spawn_stats_t	stats;
+  int			pipid, ntasks, i;
+
+  if( argc < 2 ) {
+    fprintf( stderr, "spawn_stats <ntasks>\n" );
+    exit( 1 );
+  }
+  ntasks = atoi( argv[1] );
+  if( ntasks <= 0 || ntasks > NTASKS ) {
+    fprintf( stderr, "Illegal number of tasks is specified.\n" );
+    exit( 1 );
+  }
+
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  for( i=0; i<ntasks; i++ ) {
+    pipid = i;
+    TESTINT( pip_spawn( nargv[0], nargv, NULL, i % cpu_num_limit(),
+			&pipid, NULL, NULL, NULL ) );
+  }
+  for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+
+  TESTINT( pip_get_spawn_stats( &stats ) );
+  if( stats.phase[PIP_SPAWN_PHASE_SLOT].count != ntasks ||
+      stats.phase[PIP_SPAWN_PHASE_MAIN].count != ntasks ||
+      stats.ns_per_tick <= 0.0 ) {
+    fprintf( stderr, "spawn_stats: slot=%lu main=%lu ns/tick=%g !!!!!!\n",
+	     (unsigned long) stats.phase[PIP_SPAWN_PHASE_SLOT].count,
+	     (unsigned long) stats.phase[PIP_SPAWN_PHASE_MAIN].count,
+	     stats.ns_per_tick );
+  }
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+
+#define STACKSZ		(4*1024*1024)
+
+int main( int argc, char **argv ) {
+  pip_spawn_attr_t	attr;
+  cpu_set_t		cpuset;
+  char			*nargv[3], nstr[16];
+  int			pipid, ntasks, ncores, i;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  if( pipid == PIP_PIPID_ROOT ) {
+    if( argc < 2 ) {
+      fprintf( stderr, "spawnattr <ntasks>\n" );
+      exit( 1 );
+    }
+    ntasks = atoi( argv[1] );
+    if( ntasks <= 0 || ntasks > NTASKS ) {
+      fprintf( stderr, "Illegal number of tasks is specified.\n" );
+      exit( 1 );
+    }
+    /* bind each task to (up to) two cores */
+    ncores = ( cpu_num_limit() > 1 ) ? 2 : 1;
+    sprintf( nstr, "%d", ncores );
+    nargv[0] = argv[0];
+    nargv[1] = nstr;
+    nargv[2] = NULL;
+
+    CPU_ZERO( &cpuset );
+    for( i=0; i<ncores; i++ ) CPU_SET( i, &cpuset );
+    TESTINT( pip_spawn_attr_init( &attr ) );
+    TESTINT( pip_spawn_attr_setaffinity( &attr, sizeof(cpuset), &cpuset ) );
+    TESTINT( pip_spawn_attr_setstacksize( &attr, STACKSZ ) );
+    TESTINT( pip_spawn_attr_setschedpolicy( &attr, SCHED_BATCH, 0 ) );
+    for( i=0; i<ntasks; i++ ) {
+      pipid = i;
+      TESTINT( pip_spawn_ex( argv[0], nargv, NULL, PIP_CPUCORE_ASIS,
+			     &pipid, NULL, NULL, NULL, &attr ) );
+    }
+    TESTINT( pip_spawn_attr_destroy( &attr ) );
+    for( i=0; i<ntasks; i++ ) TESTINT( pip_wait( i, NULL ) );
+    TESTINT( pip_fin() );
+
+  } else {
+    ncores = atoi( argv[1] );
+    TESTSYSERR( sched_getaffinity( 0, sizeof(cpuset), &cpuset ) );
+    if( CPU_COUNT( &cpuset ) != ncores ) {
+      fprintf( stderr, "<%d> bound to %d cores (%d expected) !!!!\n",
+	       pipid, CPU_COUNT( &cpuset ), ncores );
+    } else if( sched_getscheduler( 0 ) != SCHED_BATCH ) {
+      fprintf( stderr, "<%d> scheduling policy is not set !!!!\n", pipid );
+    } else {
+      fprintf( stderr, "<%d> Hello, I am fine !!\n", pipid );
+    }
+  }
+  return 0;
+}
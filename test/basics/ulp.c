@@ -0,0 +1,145 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+#include <pip_ulp.h>
+
+extern int pip_ulp_do_finalize( int, int* );
+
+#define NULPS		(2)
+#define NROUNDS		(2)
+#define NYIELDS		(10)
+#define DEPTH		(64)
+
+typedef struct {
+  pip_ulp_t		task;
+  pip_ulp_t		ulp[NULPS];
+  int			done[NULPS];
+} ulp_comm_t;
+
+typedef struct {
+  ulp_comm_t		*comm;
+  int			idx;
+} ulp_arg_t;
+
+/* touch some stack pages across the yields */
+static int recurse( ulp_arg_t *arg, int depth ) {
+  volatile char buf[1024];
+  int x;
+
+  buf[0] = depth;
+  if( depth == 0 ) {
+    TESTINT( pip_ulp_yield_to( &arg->comm->ulp[arg->idx], &arg->comm->task ) );
+    return 0;
+  }
+  x = recurse( arg, depth - 1 );
+  return x + buf[0];
+}
+
+static int ulp_main( char *argp ) {
+  ulp_arg_t	*arg = (ulp_arg_t*) strtoul( argp, NULL, 16 );
+  int		pipid, i, sum = 0;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  for( i=0; i<NYIELDS; i++ ) sum += recurse( arg, DEPTH );
+  if( sum != NYIELDS * DEPTH * ( DEPTH + 1 ) / 2 ) return 99;
+  /* returning from main(), the stack is recycled when finalized */
+  return 10 + arg->idx;
+}
+
+/* called on the stack of the terminated ULP */
+static void termcb( void *aux ) {
+  ulp_arg_t *arg = (ulp_arg_t*) aux;
+
+  arg->comm->done[arg->idx] = 1;
+  (void) pip_ulp_yield_to( NULL, &arg->comm->task );
+}
+
+static int task_main( char *prog ) {
+  ulp_comm_t	comm;
+  ulp_arg_t	args[NULPS];
+  char		ptr[NULPS][32];
+  char		*nargv[NULPS][4];
+  int		pipids[NULPS];
+  int		pipid, round, ndone, retval, i;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  TESTINT( pip_make_ulp( PIP_PIPID_MYSELF, NULL, NULL, &comm.task ) );
+  for( round=0; round<NROUNDS; round++ ) {
+    for( i=0; i<NULPS; i++ ) {
+      args[i].comm = &comm;
+      args[i].idx  = i;
+      comm.done[i] = 0;
+      sprintf( ptr[i], "%lx", (unsigned long) &args[i] );
+      nargv[i][0] = prog;
+      nargv[i][1] = "-u";
+      nargv[i][2] = ptr[i];
+      nargv[i][3] = NULL;
+      pipids[i] = PIP_PIPID_ANY;
+      TESTINT( pip_ulp_create( prog, nargv[i], NULL, &pipids[i],
+			       termcb, &args[i], &comm.ulp[i] ) );
+    }
+    do {
+      for( i=0, ndone=0; i<NULPS; i++ ) {
+	if( comm.done[i] ) {
+	  ndone ++;
+	} else {
+	  TESTINT( pip_ulp_yield_to( &comm.task, &comm.ulp[i] ) );
+	}
+      }
+    } while( ndone < NULPS );
+    for( i=0; i<NULPS; i++ ) {
+      TESTINT( pip_ulp_do_finalize( pipids[i], &retval ) );
+      if( retval != 10 + i ) {
+	fprintf( stderr, "[%d] ULP[%d] returns %d\n", pipid, i, retval );
+	return 1;
+      }
+    }
+  }
+  fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  int pipid, ntasks;
+
+  if( argc == 3 && strcmp( argv[1], "-u" ) == 0 ) return ulp_main( argv[2] );
+  if( pip_isa_piptask() ) return task_main( argv[0] );
+
+  ntasks = 1 + NULPS;
+  TESTINT( pip_init( &pipid, &ntasks, NULL, 0 ) );
+  pipid = 0;
+  TESTINT( pip_spawn( argv[0], argv, NULL, 0, &pipid, NULL, NULL, NULL ) );
+  TESTINT( pip_wait( 0, NULL ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+  * $RIKEN_copyright: 2018 Riken Center for Computational Sceience, 
+  * 	  System Software Devlopment Team. All rights researved$
+  * $PIP_VERSION: Version 1.0$
+  * $PIP_license: <Simplified BSD License>
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions are
+  * met:
+  * 
+  * 1. Redistributions of source code must retain the above copyright
+  *    notice, this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright
+  *    notice, this list of conditions and the following disclaimer in the 
+  *    documentation and/or other materials provided with the distribution.
+  * 
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  * 
+  * The views and conclusions contained in the software and documentation
+  * are those of the authors and should not be interpreted as representing
+  * official policies, either expressed or implied, of the PiP project.$
+*/
+
+#include <test.h>
+#include <pip_ulp.h>
+
+extern int pip_ulp_do_finalize( int, int* );
+
+#define NULPS		(4)
+#define NYIELDS		(100)
+#define BUFSZ		(4096)
+#define ENVNAME		"ULPSHARE_IDX"
+
+typedef struct {
+  pip_ulp_t		task;
+  pip_ulp_t		ulp[NULPS];
+  int			done[NULPS];
+} ulp_comm_t;
+
+typedef struct {
+  ulp_comm_t		*comm;
+  int			idx;
+} ulp_arg_t;
+
+/* each ULP has its own copy of them even though sharing the namespace, */
+/* but not of the ones in libc (environ)                               */
+static int	gvar;
+static char	*gbuf;
+static int	my_pipid;
+
+static int check_buf( char *buf, int c ) {
+  int i;
+  for( i=0; i<BUFSZ; i++ ) if( buf[i] != (char) c ) return 1;
+  return 0;
+}
+
+static int ulp_main( char *argp ) {
+  ulp_arg_t	*arg = (ulp_arg_t*) strtoul( argp, NULL, 16 );
+  ulp_comm_t	*comm = arg->comm;
+  char		*prev = NULL;
+  char		*env;
+  int		pipid, i, c;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  my_pipid = pipid;
+  gvar = arg->idx * NYIELDS;
+  if( ( env = getenv( ENVNAME ) ) == NULL || atoi( env ) != arg->idx ) {
+    fprintf( stderr, "ULP[%d] %s=%s\n", arg->idx, ENVNAME, env );
+    return 95;
+  }
+  for( i=0; i<NYIELDS; i++ ) {
+    c = ( arg->idx << 4 ) + ( i & 0xf );
+    if( ( gbuf = (char*) malloc( BUFSZ ) ) == NULL ) return 99;
+    memset( gbuf, c, BUFSZ );
+    TESTINT( pip_ulp_yield_to( &comm->ulp[arg->idx], &comm->task ) );
+    /* environ is in libc and not swapped, the ULP started last wins */
+    if( ( env = getenv( ENVNAME ) ) == NULL || atoi( env ) != NULPS - 1 ) {
+      fprintf( stderr, "ULP[%d] %s=%s\n", arg->idx, ENVNAME, env );
+      return 94;
+    }
+    /* the other ULPs have run, malloc()ed and free()d meanwhile */
+    if( gvar != arg->idx * NYIELDS + i ) {
+      fprintf( stderr, "ULP[%d] gvar=%d\n", arg->idx, gvar );
+      return 98;
+    }
+    if( my_pipid != pipid ) return 97;
+    if( check_buf( gbuf, c ) ) {
+      fprintf( stderr, "ULP[%d] heap is corrupted\n", arg->idx );
+      return 96;
+    }
+    free( prev );		/* free()ing after the yield */
+    prev = gbuf;
+    gvar ++;
+  }
+  free( prev );
+  return 10 + arg->idx;
+}
+
+/* called on the stack of the terminated ULP */
+static void termcb( void *aux ) {
+  ulp_arg_t *arg = (ulp_arg_t*) aux;
+
+  arg->comm->done[arg->idx] = 1;
+  (void) pip_ulp_yield_to( NULL, &arg->comm->task );
+}
+
+static int task_main( char *prog ) {
+  ulp_comm_t	comm;
+  ulp_arg_t	args[NULPS];
+  char		ptr[NULPS][32];
+  char		*nargv[NULPS][4];
+  char		env[NULPS][32];
+  char		*nenvv[NULPS][2];
+  int		pipids[NULPS];
+  int		pipid, ndone, retval, i;
+
+  TESTINT( pip_init( &pipid, NULL, NULL, 0 ) );
+  TESTINT( pip_make_ulp( PIP_PIPID_MYSELF, NULL, NULL, &comm.task ) );
+  for( i=0; i<NULPS; i++ ) {
+    args[i].comm = &comm;
+    args[i].idx  = i;
+    comm.done[i] = 0;
+    sprintf( ptr[i], "%lx", (unsigned long) &args[i] );
+    nargv[i][0] = prog;
+    nargv[i][1] = "-u";
+    nargv[i][2] = ptr[i];
+    nargv[i][3] = NULL;
+    sprintf( env[i], "%s=%d", ENVNAME, i );
+    nenvv[i][0] = env[i];
+    nenvv[i][1] = NULL;
+    pipids[i] = PIP_PIPID_ANY;
+    TESTINT( pip_ulp_create( prog, nargv[i], nenvv[i], &pipids[i],
+			     termcb, &args[i], &comm.ulp[i] ) );
+  }
+  do {
+    for( i=0, ndone=0; i<NULPS; i++ ) {
+      if( comm.done[i] ) {
+	ndone ++;
+      } else {
+	TESTINT( pip_ulp_yield_to( &comm.task, &comm.ulp[i] ) );
+      }
+    }
+  } while( ndone < NULPS );
+  for( i=0; i<NULPS; i++ ) {
+    TESTINT( pip_ulp_do_finalize( pipids[i], &retval ) );
+    if( retval != 10 + i ) {
+      fprintf( stderr, "[%d] ULP[%d] returns %d\n", pipid, i, retval );
+      return 1;
+    }
+  }
+  fprintf( stderr, "[PID=%d] Hello, my PIPID is %d\n", getpid(), pipid );
+  return 0;
+}
+
+int main( int argc, char **argv ) {
+  int pipid, ntasks;
+
+  if( argc == 3 && strcmp( argv[1], "-u" ) == 0 ) return ulp_main( argv[2] );
+  if( pip_isa_piptask() ) return task_main( argv[0] );
+
+  ntasks = 1 + NULPS;
+  TESTINT( pip_init( &pipid, &ntasks, NULL, PIP_OPT_ULPSHARE_EXPERIMENTAL ) );
+  pipid = 0;
+  TESTINT( pip_spawn( argv[0], argv, NULL, 0, &pipid, NULL, NULL, NULL ) );
+  TESTINT( pip_wait( 0, NULL ) );
+  TESTINT( pip_fin() );
+  return 0;
+}
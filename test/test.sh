@@ -57,6 +57,7 @@ mv -f ${TEST_LOG_FILE} ${TEST_LOG_FILE}.bak 2>/dev/null
 pip_mode_name_P=process
 pip_mode_name_L=$pip_mode_name_P:preload
 pip_mode_name_C=$pip_mode_name_P:pipclone
+pip_mode_name_K=$pip_mode_name_P:clone
 pip_mode_name_T=pthread
 
 print_mode_list()
@@ -66,12 +67,13 @@ print_mode_list()
     echo "  " $pip_mode_name_P "(P)";
     echo "  " $pip_mode_name_L "(L)";
     echo "  " $pip_mode_name_C "(C)";
+    echo "  " $pip_mode_name_K "(K)";
     exit 1;
 }
 
 print_usage()
 {
-    echo >&2 "Usage: `basename $cmd` [-APCLT] [-thread] [-process[:preload|:pipclone]] [<test_list_file>]";
+    echo >&2 "Usage: `basename $cmd` [-APCLKT] [-thread] [-process[:preload|:pipclone|:clone]] [<test_list_file>]";
     exit 2;
 }
 
@@ -81,25 +83,28 @@ case $# in
 0)	print_usage;;
 *)	run_test_L=''
 	run_test_C=''
+	run_test_K=''
 	run_test_T=''
 	while	case $1 in
 		-*) true;;
 		*) false;;
 		esac
 	do
-		case $1 in *A*)	run_test_L=L; run_test_C=C; run_test_T=T;; esac
+		case $1 in *A*)	run_test_L=L; run_test_C=C; run_test_K=K; run_test_T=T;; esac
 		case $1 in *P*)	run_test_L=L; run_test_C=C;; esac
 		case $1 in *C*)	run_test_C=C;; esac
 		case $1 in *L*)	run_test_L=L;; esac
+		case $1 in *K*)	run_test_K=K;; esac
 		case $1 in *T*)	run_test_T=T;; esac
 		case $1 in *list*) print_mode_list;; esac
 		case $1 in *thread)    run_test_T=T;; esac
 		case $1 in *process)   run_test_L=L; run_test_C=C;; esac
 		case $1 in *$pip_mode_name_L) run_test_L=L;; esac
 		case $1 in *$pip_mode_name_C) run_test_C=C;; esac
+		case $1 in *$pip_mode_name_K) run_test_K=K;; esac
 		shift
 	done
-	pip_mode_list="$run_test_L $run_test_C $run_test_T"
+	pip_mode_list="$run_test_L $run_test_C $run_test_K $run_test_T"
 	;;
 esac
 case $# in
@@ -118,7 +123,7 @@ if [ -n "$MCEXEC" ]; then
     pip_mode_list_all='T';
     echo MCEXEC=$MCEXEC
 else
-    pip_mode_list_all='L C T';
+    pip_mode_list_all='L C K T';
 fi
 
 echo LD_LIBRARY_PATH=$LD_LIBRARY_PATH
@@ -128,6 +133,7 @@ echo NTASKS: ${TEST_PIP_TASKS}
 # check whether each $PIP_MODE is testable or not
 run_test_L=''
 run_test_C=''
+run_test_K=''
 run_test_T=''
 for pip_mode in $pip_mode_list
 do
@@ -140,7 +146,7 @@ do
 	*)	echo >&2 "WARNING: $pip_mode_name is not testable";;
 	esac
 done
-pip_mode_list="$run_test_L $run_test_C $run_test_T"
+pip_mode_list="$run_test_L $run_test_C $run_test_K $run_test_T"
 
 echo
 
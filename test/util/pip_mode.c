@@ -44,11 +44,14 @@ main(int argc, char **argv)
   int option_pip_mode = 0;
   int pipid;
 
-  while ((c = getopt( argc, argv, "CLPT" )) != -1) {
+  while ((c = getopt( argc, argv, "CKLPT" )) != -1) {
     switch (c) {
     case 'C':
       option_pip_mode = PIP_MODE_PROCESS_PIPCLONE;
       break;
+    case 'K':
+      option_pip_mode = PIP_MODE_PROCESS_CLONE;
+      break;
     case 'L':
       option_pip_mode = PIP_MODE_PROCESS_PRELOAD;
       break;
@@ -59,7 +62,7 @@ main(int argc, char **argv)
       option_pip_mode = PIP_MODE_PTHREAD;
       break;
     default:
-      fprintf(stderr, "Usage: pip_mode [-CLPT]\n");
+      fprintf(stderr, "Usage: pip_mode [-CKLPT]\n");
       exit(2);
     }
   }
@@ -90,6 +93,9 @@ main(int argc, char **argv)
   case PIP_MODE_PROCESS_PIPCLONE:
     printf( "%s\n", PIP_ENV_MODE_PROCESS_PIPCLONE );
     break;
+  case PIP_MODE_PROCESS_CLONE:
+    printf( "%s\n", PIP_ENV_MODE_PROCESS_CLONE );
+    break;
   case PIP_MODE_PROCESS_PRELOAD:
     printf( "%s\n", PIP_ENV_MODE_PROCESS_PRELOAD );
     break;